@@ -0,0 +1,171 @@
+#ifndef ANALOGCHANNEL_H
+#define ANALOGCHANNEL_H
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ADC_VREF_MV 3300.0f
+#define ADC_MAX_COUNT 4095.0f
+
+// Everything a probe needs is fixed at compile time, so each channel gets its own straight-line
+// conversion code. Adding a probe is a table plus one typedef, e.g.
+//
+//   constexpr CurvePoint orpCurve[] = {{0, -2000}, {3300, 2000}};
+//   typedef AnalogChannel<33, PiecewiseLinear(orpCurve), Millivolts, MovingAverage<8>> OrpChannel;
+
+struct CurvePoint
+{
+    float in;  // millivolts at the pin
+    float out; // reading in the channel's unit
+};
+
+template <size_t N>
+constexpr size_t curveSize(const CurvePoint (&)[N])
+{
+    return N;
+}
+
+// Linear interpolation through a sorted constexpr table, extrapolating past both ends.
+// Written as a sum of clamped segment contributions so there is no search and no branch per sample.
+template <const CurvePoint *Table, size_t N>
+struct PiecewiseLinearCurve
+{
+    static_assert(N >= 2, "a curve needs at least two points");
+
+    static float apply(float mv, float)
+    {
+        float y = Table[0].out;
+
+        for (size_t i = 0; i + 1 < N; i++)
+        {
+            float width = Table[i + 1].in - Table[i].in;
+            float slope = (Table[i + 1].out - Table[i].out) / width;
+            float dx = mv - Table[i].in;
+
+            if (i > 0)
+                dx = fmaxf(dx, 0.0f);
+            if (i + 2 < N)
+                dx = fminf(dx, width);
+
+            y += slope * dx;
+        }
+        return y;
+    }
+};
+
+#define PiecewiseLinear(table) PiecewiseLinearCurve<table, curveSize(table)>
+
+// Units
+struct Celsius
+{
+    static const char *symbol() { return "C"; }
+};
+struct Millivolts
+{
+    static const char *symbol() { return "mV"; }
+};
+struct PhUnits
+{
+    static const char *symbol() { return "pH"; }
+};
+struct Percent
+{
+    static const char *symbol() { return "%"; }
+};
+struct MilligramsPerLitre
+{
+    static const char *symbol() { return "mg/L"; }
+};
+
+// Filters, applied to the millivolt reading before conversion
+struct NoFilter
+{
+    float apply(float mv) { return mv; }
+};
+
+template <uint8_t N>
+struct MovingAverage
+{
+    float window[N];
+    float sum;
+    uint8_t index, count;
+
+    float apply(float mv)
+    {
+        if (count == N)
+            sum -= window[index];
+        else
+            count++;
+
+        window[index] = mv;
+        sum += mv;
+        index = (index + 1) % N;
+        return sum / count;
+    }
+};
+
+// Exponential smoothing with alpha = 1 / 2^Shift
+template <uint8_t Shift>
+struct ExponentialAverage
+{
+    float value;
+    bool primed;
+
+    float apply(float mv)
+    {
+        value = primed ? value + (mv - value) / (1 << Shift) : mv;
+        primed = true;
+        return value;
+    }
+};
+
+template <uint8_t Pin, typename Conversion, typename Unit, typename Filter = NoFilter>
+class AnalogChannel
+{
+public:
+    static const uint8_t pin = Pin;
+
+#ifdef ARDUINO
+    static uint16_t read()
+    {
+        return analogRead(Pin);
+    }
+#endif
+
+    static float millivolts(uint16_t raw)
+    {
+        return raw * (ADC_VREF_MV / ADC_MAX_COUNT);
+    }
+
+    // Live samples only: a raw ADC count through the channel's filter, which keeps state between calls
+    static float filter(uint16_t raw)
+    {
+        return filterState.apply(millivolts(raw));
+    }
+
+    // Pure conversion of a millivolt reading, filtered or straight from millivolts() for history and
+    // replay; temperature is passed through for compensating probes
+    static float convert(float mv, float temperature)
+    {
+        return Conversion::apply(mv, temperature);
+    }
+    // Raw counts go through filter() or millivolts() first
+    static float convert(uint16_t raw, float temperature) = delete;
+
+    static const char *unit()
+    {
+        return Unit::symbol();
+    }
+
+private:
+    static Filter filterState;
+};
+
+template <uint8_t Pin, typename Conversion, typename Unit, typename Filter>
+Filter AnalogChannel<Pin, Conversion, Unit, Filter>::filterState;
+
+#endif
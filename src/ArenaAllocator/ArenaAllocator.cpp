@@ -0,0 +1,90 @@
+#include "ArenaAllocator.h"
+#include <string.h>
+
+#define ARENA_ALIGN 8
+#define ARENA_HEADER ARENA_ALIGN
+
+static size_t alignUp(size_t n)
+{
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+ArenaAllocator::ArenaAllocator(uint8_t *buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _used(0), _peak(0), _last(0), _live(0), _failures(0)
+{
+}
+
+void *ArenaAllocator::allocate(size_t size)
+{
+    size_t need = ARENA_HEADER + alignUp(size);
+
+    if (_used + need > _capacity)
+    {
+        _failures++;
+        return nullptr;
+    }
+
+    uint8_t *block = _buffer + _used;
+    *(size_t *)block = size;
+
+    _last = _used;
+    _used += need;
+    _live++;
+    if (_used > _peak)
+        _peak = _used;
+
+    return block + ARENA_HEADER;
+}
+
+void ArenaAllocator::deallocate(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    // Give back the tail block straight away so grow/shrink cycles don't leak space
+    if ((uint8_t *)ptr - ARENA_HEADER == _buffer + _last)
+        _used = _last;
+
+    if (--_live == 0)
+        _used = _last = 0;
+}
+
+void *ArenaAllocator::reallocate(void *ptr, size_t new_size)
+{
+    if (ptr == nullptr)
+        return allocate(new_size);
+
+    uint8_t *block = (uint8_t *)ptr - ARENA_HEADER;
+    size_t old_size = *(size_t *)block;
+
+    // The most recent block can be resized in place
+    if (block == _buffer + _last)
+    {
+        size_t need = ARENA_HEADER + alignUp(new_size);
+        if (_last + need > _capacity)
+        {
+            _failures++;
+            return nullptr;
+        }
+
+        *(size_t *)block = new_size;
+        _used = _last + need;
+        if (_used > _peak)
+            _peak = _used;
+        return ptr;
+    }
+
+    if (new_size <= old_size)
+    {
+        *(size_t *)block = new_size;
+        return ptr;
+    }
+
+    void *moved = allocate(new_size);
+    if (moved == nullptr)
+        return nullptr;
+
+    memcpy(moved, ptr, old_size);
+    _live--; // the old block is abandoned in place until the arena rewinds
+    return moved;
+}
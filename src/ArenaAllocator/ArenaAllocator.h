@@ -0,0 +1,33 @@
+#ifndef ARENAALLOCATOR_H
+#define ARENAALLOCATOR_H
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator over a caller-owned buffer, lets a JsonDocument live without touching the heap.
+// The arena rewinds once every block handed out has been released.
+class ArenaAllocator : public ArduinoJson::Allocator
+{
+public:
+    ArenaAllocator(uint8_t *buffer, size_t capacity);
+
+    void *allocate(size_t size) override;
+    void deallocate(void *ptr) override;
+    void *reallocate(void *ptr, size_t new_size) override;
+
+    size_t used() const { return _used; }
+    size_t peak() const { return _peak; }
+    uint32_t failures() const { return _failures; }
+
+private:
+    uint8_t *_buffer;
+    size_t _capacity;
+    size_t _used;
+    size_t _peak;
+    size_t _last;
+    uint32_t _live;
+    uint32_t _failures;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "Console.h"
+#include <SensorTrace/SensorTrace.h>
+
+static const ConsoleCommand *commandTable;
+static size_t commandCount;
+
+static char line[CONSOLE_LINE_SIZE];
+static size_t lineLength;
+static bool lineOverflow;
+
+static struct
+{
+    bool active;
+    bool finished;
+    uint32_t next, end;
+    uint8_t frame[TRACE_FRAME_SIZE(CONSOLE_FRAME_SAMPLES)];
+    size_t frameLength, frameSent;
+} exportState;
+
+ConsoleLog Log;
+
+size_t ConsoleLog::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t ConsoleLog::write(const uint8_t *buffer, size_t size)
+{
+    // Claim the bytes were written so callers don't retry into the export
+    if (exportState.active || _out == nullptr)
+    {
+        _suppressed += size;
+        return size;
+    }
+    return _out->write(buffer, size);
+}
+
+void ConsoleLog::reportSuppressed()
+{
+    if (_suppressed == 0 || _out == nullptr)
+        return;
+
+    _out->printf("[%lu log bytes suppressed during export]\n", (unsigned long)_suppressed);
+    _suppressed = 0;
+}
+
+void consoleBegin(const ConsoleCommand *commands, size_t count)
+{
+    commandTable = commands;
+    commandCount = count;
+}
+
+void consolePrintHelp(Print &out)
+{
+    for (size_t i = 0; i < commandCount; i++)
+        out.printf("%-8s %s\n", commandTable[i].name, commandTable[i].help);
+}
+
+static void dispatch(char *input)
+{
+    while (*input == ' ')
+        input++;
+    if (*input == '\0')
+        return;
+
+    // A bare number keeps working as a menu switch, as it did before the console existed
+    const char *name = input;
+    char *args = input;
+    if (!isdigit((unsigned char)*input))
+    {
+        args = strchr(input, ' ');
+        if (args)
+        {
+            *args++ = '\0';
+            while (*args == ' ')
+                args++;
+        }
+        else
+            args = input + strlen(input);
+    }
+    else
+        name = "menu";
+
+    for (size_t i = 0; i < commandCount; i++)
+    {
+        if (strcmp(commandTable[i].name, name) == 0)
+        {
+            commandTable[i].run(args);
+            return;
+        }
+    }
+
+    Log.printf("Unknown command: %s\n", name);
+    consolePrintHelp(Log);
+}
+
+// Fills the frame buffer with the next batch of samples, or the terminating empty frame
+static void buildFrame()
+{
+    RawSample samples[CONSOLE_FRAME_SAMPLES];
+    uint8_t count = 0;
+    uint32_t first, end, firstSeq;
+
+    // Samples that were overwritten while exporting are skipped rather than sent stale
+    traceHistoryRange(first, end);
+    if (exportState.next < first)
+        exportState.next = first;
+
+    firstSeq = exportState.next;
+    while (count < CONSOLE_FRAME_SAMPLES && exportState.next < exportState.end &&
+           traceHistoryGet(exportState.next, samples[count]))
+    {
+        exportState.next++;
+        count++;
+    }
+
+    exportState.frameLength = traceEncodeFrame(exportState.frame, firstSeq, samples, count);
+    exportState.frameSent = 0;
+    exportState.finished = count == 0;
+}
+
+static void pumpExport(Stream &io)
+{
+    while (exportState.active)
+    {
+        if (exportState.frameSent == exportState.frameLength)
+        {
+            if (exportState.finished)
+            {
+                exportState.active = false;
+                Log.reportSuppressed();
+                return;
+            }
+            buildFrame();
+        }
+
+        size_t room = io.availableForWrite();
+        size_t remaining = exportState.frameLength - exportState.frameSent;
+        if (room == 0)
+            return;
+
+        size_t n = io.write(exportState.frame + exportState.frameSent, room < remaining ? room : remaining);
+        exportState.frameSent += n;
+        if (n == 0)
+            return;
+    }
+}
+
+bool consoleExportBegin(uint32_t first, uint32_t end)
+{
+    if (exportState.active)
+        return false;
+
+    exportState.active = true;
+    exportState.finished = false;
+    exportState.next = first;
+    exportState.end = end;
+    exportState.frameLength = exportState.frameSent = 0;
+    return true;
+}
+
+bool consoleExportActive()
+{
+    return exportState.active;
+}
+
+void consolePoll(Stream &io)
+{
+    int available = io.available();
+
+    while (available-- > 0)
+    {
+        char c = io.read();
+
+        if (c == '\n' || c == '\r')
+        {
+            if (lineOverflow)
+                Log.println("Command too long");
+            else
+            {
+                line[lineLength] = '\0';
+                dispatch(line);
+            }
+            lineLength = 0;
+            lineOverflow = false;
+        }
+        else if (lineLength < CONSOLE_LINE_SIZE - 1)
+            line[lineLength++] = c;
+        else
+            lineOverflow = true;
+    }
+
+    pumpExport(io);
+}
@@ -0,0 +1,46 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+#define CONSOLE_LINE_SIZE 96
+#define CONSOLE_FRAME_SAMPLES 8 // per binary export frame, see TraceCodec.h for the layout
+
+struct ConsoleCommand
+{
+    const char *name;
+    void (*run)(char *args);
+    const char *help;
+};
+
+// Log output that stays off the wire while a binary export runs, so the frames arrive intact.
+// Suppressed bytes are counted and reported once the export ends.
+class ConsoleLog : public Print
+{
+public:
+    void begin(Print &out) { _out = &out; }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    void reportSuppressed();
+
+private:
+    Print *_out = nullptr;
+    uint32_t _suppressed = 0;
+};
+
+extern ConsoleLog Log;
+
+void consoleBegin(const ConsoleCommand *commands, size_t count);
+
+// Call every loop: consumes whatever input is buffered and pushes pending export bytes, never waits
+void consolePoll(Stream &io);
+
+void consolePrintHelp(Print &out);
+
+// Queues the sample history [first, end) for binary export, returns false if one is already running
+bool consoleExportBegin(uint32_t first, uint32_t end);
+bool consoleExportActive();
+
+#endif
@@ -0,0 +1,55 @@
+#include "Crc32.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TRAILER_PREFIX "\n#crc32:"
+#define TRAILER_PREFIX_LEN 8
+
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+void crc32FormatTrailer(char *out, uint32_t crc)
+{
+    snprintf(out, CRC32_TRAILER_SIZE + 1, TRAILER_PREFIX "%08lx", (unsigned long)crc);
+}
+
+bool crc32ParseTrailer(const char *text, uint32_t &crc)
+{
+    if (memcmp(text, TRAILER_PREFIX, TRAILER_PREFIX_LEN) != 0)
+        return false;
+
+    crc = 0;
+    for (size_t i = TRAILER_PREFIX_LEN; i < CRC32_TRAILER_SIZE; i++)
+    {
+        char c = text[i];
+
+        if (c >= '0' && c <= '9')
+            crc = (crc << 4) | (c - '0');
+        else if (c >= 'a' && c <= 'f')
+            crc = (crc << 4) | (c - 'a' + 10);
+        else
+            return false;
+    }
+    return true;
+}
+
+Crc32Trailer crc32CheckTrailer(const uint8_t *data, size_t len, size_t &bodyLen)
+{
+    uint32_t crc;
+
+    bodyLen = len;
+    if (len < CRC32_TRAILER_SIZE || !crc32ParseTrailer((const char *)data + len - CRC32_TRAILER_SIZE, crc))
+        return CRC32_TRAILER_MISSING;
+
+    bodyLen = len - CRC32_TRAILER_SIZE;
+    return crc32Update(0, data, bodyLen) == crc ? CRC32_TRAILER_OK : CRC32_TRAILER_MISMATCH;
+}
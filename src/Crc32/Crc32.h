@@ -0,0 +1,29 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Files written through ReadFile end with "\n#crc32:xxxxxxxx", the CRC of everything before it
+#define CRC32_TRAILER_SIZE 16
+
+enum Crc32Trailer
+{
+    CRC32_TRAILER_OK,
+    CRC32_TRAILER_MISSING, // written before checksums existed (e.g. the factory image), taken as is
+    CRC32_TRAILER_MISMATCH,
+};
+
+// CRC-32 (IEEE 802.3), pass 0 to start and the previous result to continue
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len);
+
+// Writes the trailer for crc and a terminating NUL, out holds CRC32_TRAILER_SIZE + 1 chars
+void crc32FormatTrailer(char *out, uint32_t crc);
+
+// Parses the CRC32_TRAILER_SIZE chars at text, returns false when they are not a trailer
+bool crc32ParseTrailer(const char *text, uint32_t &crc);
+
+// Checks data against its trailer, bodyLen receives the length without it
+Crc32Trailer crc32CheckTrailer(const uint8_t *data, size_t len, size_t &bodyLen);
+
+#endif
@@ -0,0 +1,209 @@
+#include "Deflate.h"
+#include <string.h>
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define MAX_CHAIN 16
+#define END_OF_BLOCK 256
+#define NO_POSITION 0xFFFF
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Deflate packs fields least significant bit first, Huffman codes most significant bit first
+struct BitWriter
+{
+    uint8_t *out;
+    size_t len, pos;
+    uint32_t bits;
+    uint8_t count;
+    bool ok;
+
+    void put(uint32_t value, uint8_t n)
+    {
+        bits |= value << count;
+        count += n;
+        while (count >= 8)
+        {
+            if (pos < len)
+                out[pos++] = bits;
+            else
+                ok = false;
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    void code(uint32_t value, uint8_t n)
+    {
+        uint32_t reversed = 0;
+
+        for (uint8_t i = 0; i < n; i++)
+            reversed |= ((value >> i) & 1) << (n - 1 - i);
+        put(reversed, n);
+    }
+
+    void flush()
+    {
+        if (count > 0)
+            put(0, 8 - count);
+    }
+
+    // Fixed literal/length code of RFC 1951 3.2.6
+    void symbol(uint16_t s)
+    {
+        if (s < 144)
+            code(0x30 + s, 8);
+        else if (s < 256)
+            code(0x190 + s - 144, 9);
+        else if (s < 280)
+            code(s - 256, 7);
+        else
+            code(0xC0 + s - 280, 8);
+    }
+
+    void match(uint16_t length, uint16_t distance)
+    {
+        uint8_t i = 28;
+
+        while (lengthBase[i] > length)
+            i--;
+        symbol(257 + i);
+        put(length - lengthBase[i], lengthExtra[i]);
+
+        i = 29;
+        while (distanceBase[i] > distance)
+            i--;
+        code(i, 5);
+        put(distance - distanceBase[i], distanceExtra[i]);
+    }
+};
+
+static uint16_t hash3(const uint8_t *p)
+{
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+static void insert(DeflateWorkspace &work, const uint8_t *in, size_t pos)
+{
+    uint16_t h = hash3(in + pos);
+
+    work.prev[pos % DEFLATE_WINDOW] = work.head[h];
+    work.head[h] = pos;
+}
+
+// Longest earlier match for in[pos..] within the window, following at most MAX_CHAIN candidates
+static uint16_t longestMatch(const DeflateWorkspace &work, const uint8_t *in, size_t len, size_t pos, uint16_t &distance)
+{
+    size_t limit = len - pos < MAX_MATCH ? len - pos : MAX_MATCH;
+    uint16_t best = 0;
+    uint16_t candidate = work.head[hash3(in + pos)];
+
+    for (int chain = 0; chain < MAX_CHAIN && candidate != NO_POSITION && pos - candidate <= DEFLATE_WINDOW; chain++)
+    {
+        uint16_t n = 0;
+
+        while (n < limit && in[candidate + n] == in[pos + n])
+            n++;
+        if (n > best)
+        {
+            best = n;
+            distance = pos - candidate;
+            if (n == limit)
+                break;
+        }
+
+        uint16_t older = work.prev[candidate % DEFLATE_WINDOW];
+        if (older == NO_POSITION || older >= candidate)
+            break;
+        candidate = older;
+    }
+
+    return best >= MIN_MATCH ? best : 0;
+}
+
+uint32_t adler32(const uint8_t *data, size_t len)
+{
+    uint32_t a = 1, b = 0;
+
+    while (len > 0)
+    {
+        // 5552 bytes is the most that can be summed before b may overflow 32 bits
+        size_t n = len < 5552 ? len : 5552;
+
+        len -= n;
+        while (n--)
+        {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+size_t deflateCompress(DeflateWorkspace &work, const uint8_t *in, size_t len, uint8_t *out, size_t outLen)
+{
+    BitWriter w = {out, outLen, 0, 0, 0, true};
+    size_t pos = 0;
+    uint32_t check;
+
+    if (len > DEFLATE_MAX_INPUT)
+        return 0;
+
+    memset(work.head, 0xFF, sizeof(work.head));
+
+    // zlib header: deflate with a 1 KiB window (CINFO 2), FCHECK makes it a multiple of 31
+    uint8_t cmf = 0x28;
+    w.put(cmf, 8);
+    w.put(31 - ((cmf << 8) % 31), 8);
+
+    // One final block with the fixed Huffman codes
+    w.put(1, 1);
+    w.put(1, 2);
+
+    while (pos < len)
+    {
+        uint16_t length = 0, distance = 0;
+
+        if (len - pos >= MIN_MATCH)
+        {
+            length = longestMatch(work, in, len, pos, distance);
+            insert(work, in, pos);
+        }
+
+        if (length == 0)
+        {
+            w.symbol(in[pos++]);
+            continue;
+        }
+
+        w.match(length, distance);
+        for (size_t end = pos + length, p = pos + 1; p < end && p + MIN_MATCH <= len; p++)
+            insert(work, in, p);
+        pos += length;
+    }
+
+    w.symbol(END_OF_BLOCK);
+    w.flush();
+
+    check = adler32(in, len);
+    w.put(check >> 24, 8);
+    w.put((check >> 16) & 0xFF, 8);
+    w.put((check >> 8) & 0xFF, 8);
+    w.put(check & 0xFF, 8);
+
+    return w.ok ? w.pos : 0;
+}
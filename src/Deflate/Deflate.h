@@ -0,0 +1,27 @@
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+// Plain C++ only, like PayloadCodec, so the same code runs in host tools
+#include <stddef.h>
+#include <stdint.h>
+
+// Matches reach back at most DEFLATE_WINDOW bytes, which keeps the workspace at 4 KiB
+#define DEFLATE_WINDOW 1024
+#define DEFLATE_HASH_BITS 10
+#define DEFLATE_MAX_INPUT 0xFFFF
+
+// Match finder state, caller-owned so it can live in static memory instead of the stack
+struct DeflateWorkspace
+{
+    uint16_t head[1 << DEFLATE_HASH_BITS];
+    uint16_t prev[DEFLATE_WINDOW];
+};
+
+// Compresses in as one zlib stream (RFC 1950 around a fixed-Huffman RFC 1951 block), which is
+// what HTTP means by Content-Encoding: deflate. Returns its length, 0 if it does not fit in out
+// or in is longer than DEFLATE_MAX_INPUT.
+size_t deflateCompress(DeflateWorkspace &work, const uint8_t *in, size_t len, uint8_t *out, size_t outLen);
+
+uint32_t adler32(const uint8_t *data, size_t len);
+
+#endif
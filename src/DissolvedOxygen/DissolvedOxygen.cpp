@@ -1,7 +1,5 @@
 #include "DissolvedOxygen.h"
-
-#define VREF 3300
-#define ADC_RES 4095
+#include <stdint.h>
 
 #define CAL1_V (550) // mv
 #define CAL1_T (22)  // ℃
@@ -12,16 +10,18 @@ const uint16_t DO_Table[41] = {
     9080, 8900, 8730, 8570, 8410, 8250, 8110, 7960, 7820, 7690,
     7560, 7430, 7300, 7180, 7070, 6950, 6840, 6730, 6630, 6530, 6410};
 
-float getDO(uint8_t pin, uint8_t temperature_c)
+float DissolvedOxygenCurve::apply(float mv, float temperature_c)
 {
-    uint16_t ADC_Raw = analogRead(pin);
-    uint16_t ADC_Voltage = uint32_t(VREF) * ADC_Raw / ADC_RES;
+    if (isnan(temperature_c) || temperature_c == DEVICE_DISCONNECTED_C)
+        return NAN;
 
-    // Serial.println("ADC_RAW: " + String(ADC_Raw) + "\tVoltage: " + String(ADC_Voltage));
+    // The table covers 0..40 ℃
+    int t = temperature_c < 0 ? 0 : temperature_c > 40 ? 40 : (int)temperature_c;
+    float V_saturation = CAL1_V + 35.0f * (t - CAL1_T);
 
-    if (ADC_Raw == 0)
-        return 0.0;
+    // The single-point slope crosses zero near 6 ℃, colder water has no usable saturation voltage
+    if (V_saturation <= 0)
+        return NAN;
 
-    uint16_t V_saturation = (uint32_t)CAL1_V + (uint32_t)35 * temperature_c - (uint32_t)CAL1_T * 35;
-    return float((ADC_Voltage * DO_Table[temperature_c] / V_saturation) / 1000);
-}
\ No newline at end of file
+    return mv * DO_Table[t] / V_saturation / 1000;
+}
@@ -1,8 +1,18 @@
 #ifndef DISSOLVEDOXYGEN_H
 #define DISSOLVEDOXYGEN_H
 
-#include <Arduino.h>
+#include <math.h>
 
-float getDO(uint8_t pin, uint8_t temperature_c);
+// What DallasTemperature reports for a probe that doesn't answer
+#ifndef DEVICE_DISCONNECTED_C
+#define DEVICE_DISCONNECTED_C -127
+#endif
+
+// Single-point calibrated galvanic probe, saturation DO looked up by water temperature.
+// Returns NAN when the temperature is unknown or too cold for the calibration (below ~7 ℃).
+struct DissolvedOxygenCurve
+{
+    static float apply(float mv, float temperature_c);
+};
 
 #endif
@@ -0,0 +1,621 @@
+#include "HostNet.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+std::vector<HostConnection *> HostConnection::_all;
+
+// Batches are encoded and compressed one at a time, every uplink shares the buffers
+static uint8_t batch[OUTBOX_BATCH_SIZE];
+static uint8_t deflated[OUTBOX_BATCH_SIZE];
+static DeflateWorkspace workspace;
+
+uint32_t hostMillis()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000);
+}
+
+static bool resolve(const RealtimeEndpoint &endpoint, struct sockaddr_in &addr)
+{
+    struct addrinfo hints = {}, *result;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(endpoint.port);
+    if (inet_pton(AF_INET, endpoint.host, &addr.sin_addr) == 1)
+        return true;
+
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(endpoint.host, nullptr, &hints, &result) != 0)
+        return false;
+    addr.sin_addr = ((struct sockaddr_in *)result->ai_addr)->sin_addr;
+    freeaddrinfo(result);
+    return true;
+}
+
+static void base64(const uint8_t *in, size_t len, std::string &out)
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t n = in[i] << 16 | (i + 1 < len ? in[i + 1] << 8 : 0) | (i + 2 < len ? in[i + 2] : 0);
+        out += table[n >> 18 & 63];
+        out += table[n >> 12 & 63];
+        out += i + 1 < len ? table[n >> 6 & 63] : '=';
+        out += i + 2 < len ? table[n & 63] : '=';
+    }
+}
+
+// Status code of a complete HTTP response in `in`, 0 while it is still arriving
+static int parseResponse(const std::string &in, bool closed, std::string *body)
+{
+    size_t headerEnd = in.find("\r\n\r\n");
+    size_t length = 0;
+    int status;
+
+    if (headerEnd == std::string::npos || sscanf(in.c_str(), "HTTP/1.%*d %d", &status) != 1)
+        return closed ? -1 : 0;
+
+    size_t field = in.find("\r\nContent-Length:");
+    if (field == std::string::npos)
+        field = in.find("\r\ncontent-length:");
+    if (field != std::string::npos && field < headerEnd)
+        length = strtoul(in.c_str() + field + 17, nullptr, 10);
+    else if (!closed)
+        return 0; // no length, the body runs until the server closes
+
+    if (field != std::string::npos && in.size() < headerEnd + 4 + length)
+        return closed ? -1 : 0;
+
+    if (body)
+        body->assign(in, headerEnd + 4, std::string::npos);
+    return status;
+}
+
+HostConnection::HostConnection()
+    : _fd(-1), _connecting(false)
+{
+    _all.push_back(this);
+}
+
+HostConnection::~HostConnection()
+{
+    if (_fd >= 0)
+        ::close(_fd);
+    for (size_t i = 0; i < _all.size(); i++)
+    {
+        if (_all[i] == this)
+        {
+            _all[i] = _all.back();
+            _all.pop_back();
+            break;
+        }
+    }
+}
+
+bool HostConnection::connectTo(const RealtimeEndpoint &endpoint)
+{
+    struct sockaddr_in addr;
+    int one = 1;
+
+    if (_fd >= 0 || !resolve(endpoint, addr))
+        return false;
+
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0)
+        return false;
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    _in.clear();
+    _out.clear();
+    _connecting = true;
+    if (connect(_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+    {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void HostConnection::close()
+{
+    if (_fd < 0)
+        return;
+
+    ::close(_fd);
+    _fd = -1;
+    _connecting = false;
+    _out.clear();
+    onClosed();
+}
+
+void HostConnection::queue(const void *data, size_t len)
+{
+    _out.append((const char *)data, len);
+    if (!_connecting)
+        flush();
+}
+
+void HostConnection::flush()
+{
+    while (!_out.empty() && _fd >= 0)
+    {
+        ssize_t n = send(_fd, _out.data(), _out.size(), MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                close();
+            return;
+        }
+        _out.erase(0, n);
+    }
+}
+
+short HostConnection::events() const
+{
+    return POLLIN | (_connecting || !_out.empty() ? POLLOUT : 0);
+}
+
+void HostConnection::service(short revents)
+{
+    char buffer[4096];
+
+    if (_connecting)
+    {
+        int error = 0;
+        socklen_t len = sizeof(error);
+
+        if (!(revents & (POLLOUT | POLLERR | POLLHUP)))
+            return;
+        getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error)
+        {
+            close();
+            return;
+        }
+        _connecting = false;
+        onConnected();
+        flush();
+        return;
+    }
+
+    if (revents & (POLLIN | POLLHUP | POLLERR))
+    {
+        for (;;)
+        {
+            ssize_t n = recv(_fd, buffer, sizeof(buffer), 0);
+            if (n > 0)
+            {
+                _in.append(buffer, n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            // Let the owner see the last bytes before the close, unless it already moved on
+            int fd = _fd;
+            if (!_in.empty())
+                onData();
+            if (_fd == fd)
+                close();
+            return;
+        }
+        onData();
+    }
+
+    if (_fd >= 0 && (revents & POLLOUT))
+        flush();
+}
+
+void HostConnection::pollAll(int timeoutMs)
+{
+    static std::vector<struct pollfd> fds;
+    static std::vector<HostConnection *> owners;
+
+    fds.clear();
+    owners.clear();
+    for (HostConnection *c : _all)
+    {
+        if (c->_fd < 0)
+            continue;
+        fds.push_back({c->_fd, c->events(), 0});
+        owners.push_back(c);
+    }
+
+    if (fds.empty())
+    {
+        if (timeoutMs > 0)
+            usleep(timeoutMs * 1000);
+        return;
+    }
+
+    if (poll(fds.data(), fds.size(), timeoutMs) <= 0)
+        return;
+
+    for (size_t i = 0; i < fds.size(); i++)
+    {
+        // A callback may have closed or reopened the connection, its old events no longer apply
+        if (fds[i].revents && owners[i]->_fd == fds[i].fd)
+            owners[i]->service(fds[i].revents);
+    }
+}
+
+size_t HostConnection::openCount()
+{
+    size_t n = 0;
+
+    for (HostConnection *c : _all)
+        n += c->_fd >= 0;
+    return n;
+}
+
+HostWebSocket::HostWebSocket()
+    : _endpoint(), _channel(nullptr), _upgraded(false), _reconnectAtMs(0), _reconnects(0)
+{
+}
+
+void HostWebSocket::begin(const RealtimeEndpoint &endpoint, const char *apiKey, RealtimeChannel &channel)
+{
+    _endpoint = endpoint;
+    _channel = &channel;
+    _path = REALTIME_PATH "?apikey=";
+    _path += apiKey;
+    _path += "&vsn=1.0.0";
+    open();
+}
+
+void HostWebSocket::open()
+{
+    _reconnectAtMs = hostMillis() + HOST_RECONNECT_MS;
+    connectTo(_endpoint);
+}
+
+void HostWebSocket::poll(uint32_t nowMs)
+{
+    if (!_channel)
+        return;
+
+    if (!isOpen())
+    {
+        if ((int32_t)(nowMs - _reconnectAtMs) >= 0)
+        {
+            _reconnects++;
+            open();
+        }
+        return;
+    }
+
+    _channel->poll(nowMs);
+    if (_upgraded && !_channel->healthy())
+        close();
+}
+
+void HostWebSocket::onConnected()
+{
+    uint8_t key[16];
+    std::string request;
+
+    for (size_t i = 0; i < sizeof(key); i++)
+        key[i] = rand();
+
+    request = "GET " + _path + " HTTP/1.1\r\nHost: " + _endpoint.host +
+              "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13\r\nSec-WebSocket-Key: ";
+    base64(key, sizeof(key), request);
+    request += "\r\n\r\n";
+    queue(request.data(), request.size());
+}
+
+void HostWebSocket::onData()
+{
+    if (!_upgraded)
+    {
+        size_t end = _in.find("\r\n\r\n");
+        if (end == std::string::npos)
+            return;
+        if (_in.compare(0, 12, "HTTP/1.1 101") != 0)
+        {
+            close();
+            return;
+        }
+        _in.erase(0, end + 4);
+        _upgraded = true;
+        _channel->connected(hostMillis());
+    }
+
+    // Server frames are never masked
+    while (_in.size() >= 2 && isOpen())
+    {
+        const uint8_t *p = (const uint8_t *)_in.data();
+        uint8_t opcode = p[0] & 0x0F;
+        uint64_t len = p[1] & 0x7F;
+        size_t head = 2;
+
+        if (len == 126)
+        {
+            if (_in.size() < 4)
+                return;
+            len = p[2] << 8 | p[3];
+            head = 4;
+        }
+        else if (len == 127)
+        {
+            if (_in.size() < 10)
+                return;
+            len = 0;
+            for (int i = 2; i < 10; i++)
+                len = len << 8 | p[i];
+            head = 10;
+        }
+        if (_in.size() < head + len)
+            return;
+
+        if (opcode == 0x8)
+        {
+            close();
+            return;
+        }
+        if (opcode == 0x9)
+            sendFrame(0xA, p + head, len);
+        else if (opcode <= 0x2)
+        {
+            _message.append((const char *)p + head, len);
+            if (p[0] & 0x80)
+            {
+                _channel->received(_message.data(), _message.size(), hostMillis());
+                _message.clear();
+            }
+        }
+        _in.erase(0, head + len);
+    }
+}
+
+void HostWebSocket::onClosed()
+{
+    bool wasUpgraded = _upgraded;
+
+    _upgraded = false;
+    _message.clear();
+    if (wasUpgraded)
+        _channel->disconnected();
+}
+
+bool HostWebSocket::sendText(const char *text, size_t len)
+{
+    if (!_upgraded)
+        return false;
+    sendFrame(0x1, text, len);
+    return true;
+}
+
+void HostWebSocket::sendFrame(uint8_t opcode, const void *data, size_t len)
+{
+    uint8_t head[14];
+    size_t n = 0;
+    uint32_t mask = rand();
+    const uint8_t *in = (const uint8_t *)data;
+    std::string frame;
+
+    head[n++] = 0x80 | opcode;
+    if (len < 126)
+        head[n++] = 0x80 | len;
+    else if (len < 0x10000)
+    {
+        head[n++] = 0x80 | 126;
+        head[n++] = len >> 8;
+        head[n++] = len;
+    }
+    else
+    {
+        head[n++] = 0x80 | 127;
+        for (int shift = 56; shift >= 0; shift -= 8)
+            head[n++] = (uint64_t)len >> shift;
+    }
+    memcpy(head + n, &mask, 4);
+    n += 4;
+
+    frame.assign((const char *)head, n);
+    for (size_t i = 0; i < len; i++)
+        frame += (char)(in[i] ^ head[n - 4 + (i & 3)]);
+    queue(frame.data(), frame.size());
+}
+
+HostHttpUplink::HostHttpUplink()
+    : _endpoint(), _encoding(ENCODING_JSON), _deflate(false), _busy(false), _uplink(nullptr), _lastSeq(0),
+      _startedMs(0), _lastStatus(0)
+{
+}
+
+void HostHttpUplink::begin(const RealtimeEndpoint &endpoint, const char *apiKey, PayloadEncoding encoding,
+                           bool deflate, Uplink &uplink)
+{
+    _endpoint = endpoint;
+    _apiKey = apiKey;
+    _encoding = encoding;
+    _deflate = deflate;
+    _uplink = &uplink;
+}
+
+bool HostHttpUplink::ready()
+{
+    // A request the Uplink already gave up on does not hold the transport
+    return !_busy || hostMillis() - _startedMs >= UPLINK_ACK_TIMEOUT_MS;
+}
+
+DeliveryResult HostHttpUplink::deliver(const Outbox &outbox, const char *envId, uint32_t &lastSeq)
+{
+    const uint8_t *payload = batch;
+    size_t length = outbox.encode(_encoding, batch, sizeof(batch), envId, lastSeq);
+    size_t packed = 0;
+    char head[512];
+    int n;
+
+    if (_busy)
+        finish(-1);
+    if (length == 0)
+        return DELIVERY_FAILED;
+
+    if (_deflate)
+        packed = deflateCompress(workspace, batch, length, deflated, sizeof(deflated));
+    if (packed != 0 && packed < length)
+    {
+        payload = deflated;
+        length = packed;
+    }
+
+    n = snprintf(head, sizeof(head),
+                 "POST /rest/v1/measurements?on_conflict=env_id,seq HTTP/1.1\r\nHost: %s\r\napikey: %s\r\n"
+                 "Content-Type: %s\r\n%sPrefer: resolution=ignore-duplicates,return=minimal\r\n"
+                 "Content-Length: %u\r\nConnection: close\r\n\r\n",
+                 _endpoint.host, _apiKey.c_str(), payloadContentType(_encoding),
+                 payload == deflated ? "Content-Encoding: deflate\r\n" : "", (unsigned)length);
+    if (n < 0 || (size_t)n >= sizeof(head) || !connectTo(_endpoint))
+        return DELIVERY_FAILED;
+
+    queue(head, n);
+    queue(payload, length);
+    _busy = true;
+    _lastSeq = lastSeq;
+    _startedMs = hostMillis();
+    return DELIVERY_PENDING;
+}
+
+void HostHttpUplink::onData()
+{
+    int status = parseResponse(_in, false, nullptr);
+
+    if (status != 0)
+        finish(status);
+}
+
+void HostHttpUplink::onClosed()
+{
+    if (_busy)
+    {
+        _busy = false;
+        _lastStatus = parseResponse(_in, true, nullptr);
+        _uplink->complete(this, _lastSeq, _lastStatus == 201);
+    }
+}
+
+void HostHttpUplink::finish(int status)
+{
+    _busy = false;
+    _lastStatus = status;
+    close();
+    _uplink->complete(this, _lastSeq, status == 201);
+}
+
+HostRequest::HostRequest()
+    : _status(0), _done(false)
+{
+}
+
+bool HostRequest::start(const RealtimeEndpoint &endpoint, const char *method, const char *path, const char *apiKey,
+                        const std::string &body)
+{
+    char head[512];
+    int n = snprintf(head, sizeof(head),
+                     "%s %s HTTP/1.1\r\nHost: %s\r\napikey: %s\r\nContent-Type: application/json\r\n"
+                     "Content-Length: %u\r\nConnection: close\r\n\r\n",
+                     method, path, endpoint.host, apiKey, (unsigned)body.size());
+
+    _response.clear();
+    _status = 0;
+    _done = false;
+    if (n < 0 || (size_t)n >= sizeof(head) || !connectTo(endpoint))
+    {
+        _status = -1;
+        _done = true;
+        return false;
+    }
+
+    queue(head, n);
+    queue(body.data(), body.size());
+    return true;
+}
+
+void HostRequest::onData()
+{
+    _status = parseResponse(_in, false, &_response);
+    if (_status != 0)
+    {
+        _done = true;
+        close();
+    }
+}
+
+void HostRequest::onClosed()
+{
+    if (!_done)
+        _status = parseResponse(_in, true, &_response);
+    _done = true;
+}
+
+bool HostSignIn::start(const RealtimeEndpoint &endpoint, const char *apiKey, const char *email, const char *password)
+{
+    JsonDocument doc;
+    std::string body;
+
+    doc["email"] = email;
+    doc["password"] = password;
+    serializeJson(doc, body);
+    return HostRequest::start(endpoint, "POST", "/auth/v1/token?grant_type=password", apiKey, body);
+}
+
+bool HostSignIn::token(std::string &token) const
+{
+    JsonDocument doc;
+
+    if (!done() || status() != 200)
+        return false;
+    if (deserializeJson(doc, response()) || !doc["access_token"].is<const char *>())
+        return false;
+
+    token = doc["access_token"].as<const char *>();
+    return true;
+}
+
+int hostRequest(const RealtimeEndpoint &endpoint, const char *method, const char *path, const char *apiKey,
+                const std::string &body, std::string &response)
+{
+    HostRequest request;
+    uint32_t startedAt = hostMillis();
+
+    if (!request.start(endpoint, method, path, apiKey, body))
+        return -1;
+    while (!request.done() && hostMillis() - startedAt < HOST_REQUEST_TIMEOUT_MS)
+        HostConnection::pollAll(50);
+
+    response = request.response();
+    return request.done() ? request.status() : -1;
+}
+
+bool hostSignIn(const RealtimeEndpoint &endpoint, const char *apiKey, const char *email, const char *password,
+                std::string &token)
+{
+    HostSignIn request;
+    uint32_t startedAt = hostMillis();
+
+    if (!request.start(endpoint, apiKey, email, password))
+        return false;
+    while (!request.done() && hostMillis() - startedAt < HOST_REQUEST_TIMEOUT_MS)
+        HostConnection::pollAll(50);
+
+    return request.token(token);
+}
@@ -0,0 +1,151 @@
+#ifndef HOSTNET_H
+#define HOSTNET_H
+
+// POSIX sockets for the host harnesses (soak, fleet). Everything is nonblocking and driven from
+// one poll() loop, so a single process can stand in for thousands of devices.
+#include <Deflate/Deflate.h>
+#include <Realtime/RealtimeChannel.h>
+#include <string>
+#include <vector>
+
+#define HOST_RECONNECT_MS 5000U // WebSocketsClient's reconnect interval on the device
+#define HOST_REQUEST_TIMEOUT_MS 10000
+
+uint32_t hostMillis();
+
+// One nonblocking TCP connection
+class HostConnection
+{
+public:
+    HostConnection();
+    virtual ~HostConnection();
+
+    bool connectTo(const RealtimeEndpoint &endpoint);
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+    void queue(const void *data, size_t len);
+
+    // One poll() over every open connection, waiting at most timeoutMs
+    static void pollAll(int timeoutMs);
+    static size_t openCount();
+
+protected:
+    virtual void onConnected() {}
+    // New bytes were appended to _in, erase what was consumed
+    virtual void onData() = 0;
+    virtual void onClosed() {}
+
+    std::string _in;
+
+private:
+    short events() const;
+    void service(short revents);
+    void flush();
+
+    int _fd;
+    bool _connecting;
+    std::string _out;
+
+    static std::vector<HostConnection *> _all;
+};
+
+// WebSocket client for a RealtimeChannel, reconnecting the way the firmware's Realtime does
+class HostWebSocket : public HostConnection, public RealtimeSocket
+{
+public:
+    HostWebSocket();
+
+    void begin(const RealtimeEndpoint &endpoint, const char *apiKey, RealtimeChannel &channel);
+    // Reconnects, runs the channel timers and drops the socket when heartbeats go unanswered
+    void poll(uint32_t nowMs);
+
+    bool upgraded() const { return _upgraded; }
+    uint32_t reconnects() const { return _reconnects; }
+
+    bool sendText(const char *text, size_t len) override;
+
+private:
+    void open();
+    void onConnected() override;
+    void onData() override;
+    void onClosed() override;
+    void sendFrame(uint8_t opcode, const void *data, size_t len);
+
+    RealtimeEndpoint _endpoint;
+    RealtimeChannel *_channel;
+    std::string _path, _message;
+    bool _upgraded;
+    uint32_t _reconnectAtMs, _reconnects;
+};
+
+// PostgREST batch upload, answering through Uplink::complete() instead of blocking
+class HostHttpUplink : public HostConnection, public UplinkTransport
+{
+public:
+    HostHttpUplink();
+
+    void begin(const RealtimeEndpoint &endpoint, const char *apiKey, PayloadEncoding encoding, bool deflate,
+               Uplink &uplink);
+
+    bool ready() override;
+    size_t capacity() const override { return OUTBOX_SIZE; }
+    DeliveryResult deliver(const Outbox &outbox, const char *envId, uint32_t &lastSeq) override;
+
+    int lastStatus() const { return _lastStatus; }
+
+private:
+    void onData() override;
+    void onClosed() override;
+    void finish(int status);
+
+    RealtimeEndpoint _endpoint;
+    std::string _apiKey;
+    PayloadEncoding _encoding;
+    bool _deflate, _busy;
+    Uplink *_uplink;
+    uint32_t _lastSeq, _startedMs;
+    int _lastStatus;
+};
+
+// One HTTP request on the shared poll loop, done() once answered, refused or closed
+class HostRequest : public HostConnection
+{
+public:
+    HostRequest();
+
+    bool start(const RealtimeEndpoint &endpoint, const char *method, const char *path, const char *apiKey,
+               const std::string &body);
+
+    bool done() const { return _done; }
+    // HTTP status, -1 for a connection closed without a complete response
+    int status() const { return _status; }
+    const std::string &response() const { return _response; }
+
+protected:
+    void onData() override;
+    void onClosed() override;
+
+private:
+    std::string _response;
+    int _status;
+    bool _done;
+};
+
+// Sign-in at /auth/v1/token that does not stall the loop, for devices booting together
+class HostSignIn : public HostRequest
+{
+public:
+    bool start(const RealtimeEndpoint &endpoint, const char *apiKey, const char *email, const char *password);
+    // False until done() with a usable token response
+    bool token(std::string &token) const;
+};
+
+// Blocking request for setup and reports (sign-in, /stats), returns the HTTP status or -1
+int hostRequest(const RealtimeEndpoint &endpoint, const char *method, const char *path, const char *apiKey,
+                const std::string &body, std::string &response);
+
+// Signs in at /auth/v1/token, token receives the access token
+bool hostSignIn(const RealtimeEndpoint &endpoint, const char *apiKey, const char *email, const char *password,
+                std::string &token);
+
+#endif
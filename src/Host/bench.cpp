@@ -0,0 +1,201 @@
+// Host benchmark: `pio run -e bench -t exec`
+// Compares the AnalogChannel conversions with the per-sensor functions they replaced, over every
+// ADC count, for speed and for how far the results drift apart. Times a trace replay through the
+// conversions, then sizes and times each wire encoding on a full outbox batch.
+#include <AnalogChannel/AnalogChannel.h>
+#include <Deflate/Deflate.h>
+#include <DissolvedOxygen/DissolvedOxygen.h>
+#include <Outbox/Outbox.h>
+#include <SensorTrace/TraceCodec.h>
+#include <chrono>
+#include <stdio.h>
+
+#define ROUNDS 2000
+#define ADC_COUNTS 4096
+#define BENCH_TEMPERATURE 25
+#define ENCODE_ROUNDS 20000
+#define REPLAY_ROUNDS 200
+#define BENCH_ID "3f2b8c1e-9a4d-4e7b-8c21-5d6e7f809a1b"
+
+// The functions as they were in main.cpp / DissolvedOxygen.cpp, with analogRead() replaced by a raw count
+namespace legacy
+{
+#define ESPVOLTAGE 3300
+#define ESPADC 4095.0
+#define VREF 3300
+#define ADC_RES 4095
+#define CAL1_V (550)
+#define CAL1_T (22)
+
+    const uint16_t DO_Table[41] = {
+        14460, 14220, 13820, 13440, 13090, 12740, 12420, 12110, 11810, 11530,
+        11260, 11010, 10770, 10530, 10300, 10080, 9860, 9660, 9460, 9270,
+        9080, 8900, 8730, 8570, 8410, 8250, 8110, 7960, 7820, 7690,
+        7560, 7430, 7300, 7180, 7070, 6950, 6840, 6730, 6630, 6530, 6410};
+
+    // Arduino's map() works on longs
+    long map(long x, long in_min, long in_max, long out_min, long out_max)
+    {
+        return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+    }
+
+    float getVoltage(uint16_t raw)
+    {
+        return raw * (ESPVOLTAGE / ESPADC);
+    }
+
+    float getTurbidity(uint16_t raw)
+    {
+        return map(getVoltage(raw), 0, 2080, 0, 100);
+    }
+
+    float getDO(uint16_t ADC_Raw, uint8_t temperature_c)
+    {
+        uint16_t ADC_Voltage = uint32_t(VREF) * ADC_Raw / ADC_RES;
+
+        if (ADC_Raw == 0)
+            return 0.0;
+
+        uint16_t V_saturation = (uint32_t)CAL1_V + (uint32_t)35 * temperature_c - (uint32_t)CAL1_T * 35;
+        return float((ADC_Voltage * DO_Table[temperature_c] / V_saturation) / 1000);
+    }
+}
+
+constexpr CurvePoint turbidityCurve[] = {{0, 0}, {2080, 100}};
+
+typedef AnalogChannel<32, PiecewiseLinear(turbidityCurve), Percent> TurbidityChannel;
+typedef AnalogChannel<35, DissolvedOxygenCurve, MilligramsPerLitre> DissolvedOxygenChannel;
+
+static volatile float sink;
+
+template <typename F>
+static double nsPerSample(F convert)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        float acc = 0;
+        for (uint16_t raw = 0; raw < ADC_COUNTS; raw++)
+            acc += convert(raw);
+        sink = acc;
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ((double)ROUNDS * ADC_COUNTS);
+}
+
+template <typename A, typename B>
+static float maxDifference(A a, B b)
+{
+    float worst = 0;
+
+    for (uint16_t raw = 0; raw < ADC_COUNTS; raw++)
+        worst = fmaxf(worst, fabsf(a(raw) - b(raw)));
+    return worst;
+}
+
+static void report(const char *name, double legacyNs, double channelNs, float diff, const char *unit)
+{
+    printf("%-18s legacy %6.2f ns  channel %6.2f ns  max diff %.3f %s\n", name, legacyNs, channelNs, diff, unit);
+}
+
+template <typename F>
+static double usPerCall(F call)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < ENCODE_ROUNDS; r++)
+        call();
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ENCODE_ROUNDS;
+}
+
+static void convertReplayed(const RawSample &sample)
+{
+    sink = TurbidityChannel::convert(TurbidityChannel::millivolts(sample.turbidity), sample.temperature) +
+           DissolvedOxygenChannel::convert(DissolvedOxygenChannel::millivolts(sample.dissolvedOxygen),
+                                           sample.temperature);
+}
+
+// A trace sweeping every ADC count, replayed through the pure conversions the way the firmware's
+// `replay` command does, minus the file, the serial output and pH (DFRobot_PH is not on the host)
+static void replay()
+{
+    static uint8_t trace[TRACE_HEADER_SIZE + ADC_COUNTS * TRACE_RECORD_SIZE];
+
+    traceEncodeHeader(trace);
+    for (uint16_t raw = 0; raw < ADC_COUNTS; raw++)
+    {
+        RawSample sample = {raw * 1000U, BENCH_TEMPERATURE, raw, raw, raw};
+        traceEncodeSample(trace + TRACE_HEADER_SIZE + raw * TRACE_RECORD_SIZE, sample);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t samples = 0;
+
+    for (int r = 0; r < REPLAY_ROUNDS; r++)
+    {
+        MemoryTraceSource source(trace, sizeof(trace));
+        samples += traceReplay(source, convertReplayed).samples;
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    printf("trace replay       %6.2f ns/record, decode and convert (%d rounds over %d records)\n",
+           elapsed.count() / samples, REPLAY_ROUNDS, ADC_COUNTS);
+}
+
+// A full outbox of slowly drifting readings five minutes apart, like a backlog after an outage
+static void encodings()
+{
+    static uint8_t batch[OUTBOX_BATCH_SIZE], deflated[OUTBOX_BATCH_SIZE];
+    static DeflateWorkspace work;
+    const PayloadEncoding modes[] = {ENCODING_JSON, ENCODING_CBOR};
+    const char *names[] = {"json", "cbor"};
+    Outbox outbox;
+    uint32_t lastSeq;
+
+    for (int i = 0; i < OUTBOX_SIZE; i++)
+    {
+        Measurement m = {25.0f + 0.0625f * (i % 5), 7.1f + 0.01f * (i % 3), 12.5f + 0.5f * (i % 4),
+                         6.8f - 0.02f * i, 1733843700UL + i * 300UL};
+        outbox.push(m);
+    }
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        size_t length = 0, compressed = 0;
+        double encodeUs = usPerCall([&]
+                                    { length = outbox.encode(modes[i], batch, sizeof(batch), BENCH_ID, lastSeq); });
+        double deflateUs = usPerCall([&]
+                                     { compressed = deflateCompress(work, batch, length, deflated, sizeof(deflated)); });
+
+        printf("%-4s          %6.1f B/reading %7.2f us/batch\n", names[i], (double)length / OUTBOX_SIZE, encodeUs);
+        printf("%-4s+deflate  %6.1f B/reading %7.2f us/batch\n", names[i], (double)compressed / OUTBOX_SIZE,
+               encodeUs + deflateUs);
+    }
+    printf("(batches of %d readings)\n", OUTBOX_SIZE);
+}
+
+int main()
+{
+    auto legacyTurbidity = [](uint16_t raw) { return legacy::getTurbidity(raw); };
+    auto channelTurbidity = [](uint16_t raw)
+    { return TurbidityChannel::convert(TurbidityChannel::filter(raw), BENCH_TEMPERATURE); };
+    report("turbidity", nsPerSample(legacyTurbidity), nsPerSample(channelTurbidity),
+           maxDifference(legacyTurbidity, channelTurbidity), TurbidityChannel::unit());
+
+    auto legacyDO = [](uint16_t raw) { return legacy::getDO(raw, BENCH_TEMPERATURE); };
+    auto channelDO = [](uint16_t raw)
+    { return DissolvedOxygenChannel::convert(DissolvedOxygenChannel::filter(raw), BENCH_TEMPERATURE); };
+    report("dissolved oxygen", nsPerSample(legacyDO), nsPerSample(channelDO),
+           maxDifference(legacyDO, channelDO), DissolvedOxygenChannel::unit());
+
+    printf("(%d rounds over %d ADC counts at %d C, pH goes through DFRobot_PH either way)\n",
+           ROUNDS, ADC_COUNTS, BENCH_TEMPERATURE);
+
+    replay();
+    encodings();
+    return 0;
+}
@@ -0,0 +1,512 @@
+// Host fleet simulator: `pio run -e fleet -t exec`, or `.pio/build/fleet/program --devices 2000 ...`
+// Runs thousands of virtual devices in one process against tools/standin/standin.py or a local stack.
+// Each device is the firmware's loop() minus the sensors: config load, the DeviceSchedule the firmware
+// samples and records by, the Outbox/Uplink pair and a RealtimeChannel with presence, signing in again
+// after failures on the firmware's SignInRetry, all on the shared poll loop of HostNet.
+//
+// --speed compresses the quiet minutes between boundaries: device clocks run that much faster,
+// while sample ticks, heartbeats, ack timeouts and retry backoff keep real time, so the burst
+// after each boundary has the shape the fleet would produce.
+// --spread records at a per-device second inside the five minutes instead. It is not what the
+// firmware does, only there to compare a spread schedule against the aligned one.
+#include <ArenaAllocator/ArenaAllocator.h>
+#include <Host/HostNet.h>
+#include <Schedule/Schedule.h>
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define FLEET_DEFAULT_URL "http://127.0.0.1:54321"
+#define FLEET_FIRST_BOUNDARY 1733843700UL
+#define FLEET_NAME_SIZE 64
+#define FLEET_CREDENTIAL_SIZE 64
+#define FLEET_HERD_BINS 30
+#define FLEET_HERD_BIN_MS 100   // wall time
+#define FLEET_HERD_LEAD_MS 500  // clock skew records a little before the boundary
+#define FLEET_FDS_PER_DEVICE 3 // websocket, upload, sign-in
+
+struct FleetOptions
+{
+    const char *url, *key;
+    uint32_t devices, durationS, speed, rampS, skewMs, reportS, seed;
+    PayloadEncoding encoding;
+    TelemetryTransport transport;
+    bool deflate, spread;
+};
+
+// Messages are built and parsed one at a time, the whole fleet shares one arena like a device does
+static uint8_t arenaBuffer[16384];
+static ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+static uint32_t changes;
+
+// Shared virtual clock: UTC milliseconds, running `speed` times faster than the wall
+static uint32_t startMs;
+static uint32_t speed;
+static uint64_t startEpochMs;
+
+static uint64_t virtualMs(uint32_t nowMs)
+{
+    return startEpochMs + (uint64_t)(nowMs - startMs) * speed;
+}
+
+static void onChange(JsonVariantConst)
+{
+    changes++;
+}
+
+// What the driver tracks across devices
+struct FleetMetrics
+{
+    std::vector<uint32_t> perSecond; // upload attempts by wall second since start
+    std::vector<uint32_t> latencies; // acknowledged deliveries, ms
+    uint32_t herd[FLEET_HERD_BINS];  // upload attempts by wall time from the nearest boundary
+    uint32_t outsideHerd;
+    uint32_t signIns, signInFailures;
+
+    void attempt(uint32_t nowMs)
+    {
+        uint32_t second = (nowMs - startMs) / 1000;
+        int64_t period = UPLOAD_PERIOD * 1000LL;
+        int64_t sinceBoundary = virtualMs(nowMs) % period;
+        int64_t offsetMs = (sinceBoundary > period / 2 ? sinceBoundary - period : sinceBoundary) / speed;
+        int64_t bin = (offsetMs + FLEET_HERD_LEAD_MS) / FLEET_HERD_BIN_MS;
+
+        if (second >= perSecond.size())
+            perSecond.resize(second + 1);
+        perSecond[second]++;
+        if (offsetMs >= -FLEET_HERD_LEAD_MS && bin < FLEET_HERD_BINS)
+            herd[bin]++;
+        else
+            outsideHerd++;
+    }
+};
+
+class VirtualDevice
+{
+public:
+    VirtualDevice()
+        : _uplink(_outbox, _id, hostMillis), _channel(_socket, &arena), _state(DEVICE_OFF), _syncEnable(false),
+          _signingIn(false), _bootAtMs(0), _signInStartedMs(0), _clockOffsetMs(0), _attempts(0), _sent(0)
+    {
+        _id[0] = _name[0] = _email[0] = _password[0] = '\0';
+    }
+
+    // config and user are the contents of data/aquarium.json and data/user.json
+    bool begin(const char *config, const char *user, uint32_t bootAtMs, int32_t clockOffsetMs, uint32_t slotS)
+    {
+        JsonDocument doc(&arena);
+
+        if (deserializeJson(doc, config) || !doc["id"].is<const char *>())
+            return false;
+        strncpy(_id, doc["id"].as<const char *>(), sizeof(_id) - 1);
+        strncpy(_name, doc["name"] | "", sizeof(_name) - 1);
+        _syncEnable = doc["enable_monitoring"].as<bool>();
+
+        if (deserializeJson(doc, user))
+            return false;
+        strncpy(_email, doc["email"] | "", sizeof(_email) - 1);
+        strncpy(_password, doc["password"] | "", sizeof(_password) - 1);
+
+        _bootAtMs = bootAtMs;
+        _clockOffsetMs = clockOffsetMs;
+        _schedule = DeviceSchedule(slotS);
+        return true;
+    }
+
+    void loop(uint32_t nowMs, const FleetOptions &o, const RealtimeEndpoint &endpoint, FleetMetrics &metrics)
+    {
+        switch (_state)
+        {
+        case DEVICE_OFF:
+            if ((int32_t)(nowMs - _bootAtMs) < 0)
+                return;
+            // setup(): the outbox numbers rows per boot, the first tick is an interval away
+            _outbox.begin(1);
+            _schedule.begin(nowMs);
+            _signInRetry.begin(nowMs);
+            _state = DEVICE_SIGNING_IN;
+            break;
+        case DEVICE_SIGNING_IN:
+            signIn(nowMs, o, endpoint, metrics);
+            break;
+        case DEVICE_RUNNING:
+            _socket.poll(nowMs);
+            break;
+        }
+
+        if (_schedule.sampleDue(nowMs))
+            tick(nowMs);
+        _uplink.poll();
+        collect(nowMs, metrics);
+    }
+
+    bool joined() const { return _channel.joined(); }
+    bool running() const { return _state == DEVICE_RUNNING; }
+    const Outbox &outbox() const { return _outbox; }
+    const Uplink &uplink() const { return _uplink; }
+    uint32_t reconnects() const { return _socket.reconnects(); }
+
+private:
+    enum State
+    {
+        DEVICE_OFF,
+        DEVICE_SIGNING_IN, // Realtime::loop() before the first login succeeded
+        DEVICE_RUNNING,
+    };
+
+    void signIn(uint32_t nowMs, const FleetOptions &o, const RealtimeEndpoint &endpoint, FleetMetrics &metrics)
+    {
+        if (!_signingIn)
+        {
+            if (_signInRetry.due(nowMs))
+            {
+                metrics.signIns++;
+                _signingIn = true;
+                _signInStartedMs = nowMs;
+                _signIn.start(endpoint, o.key, _email, _password);
+            }
+            return;
+        }
+        // HTTPClient gives up the same way
+        if (!_signIn.done() && nowMs - _signInStartedMs >= HOST_REQUEST_TIMEOUT_MS)
+            _signIn.close();
+        if (!_signIn.done())
+            return;
+
+        _signingIn = false;
+        if (!_signIn.token(_token))
+        {
+            metrics.signInFailures++;
+            _signInRetry.failed(nowMs);
+            return;
+        }
+
+        _channel.begin(_id, _token.c_str(), onChange);
+        _channel.setPresence(_name, _schedule.joinedAt());
+        _channel.setUplink(&_uplink);
+        _http.begin(endpoint, o.key, o.encoding, o.deflate, _uplink);
+        if (o.transport == TRANSPORT_REALTIME)
+            _uplink.setTransports(&_channel, &_http);
+        else
+            _uplink.setTransports(&_http, nullptr);
+        _socket.begin(endpoint, o.key, _channel);
+        _state = DEVICE_RUNNING;
+    }
+
+    // One pass of the firmware's sample branch, minus the sensors
+    void tick(uint32_t nowMs)
+    {
+        unsigned long epoch = (virtualMs(nowMs) + _clockOffsetMs) / 1000;
+        uint8_t due = _schedule.tick(epoch, _syncEnable);
+
+        if (due & SCHEDULE_JOINED)
+            _channel.setPresence(_name, _schedule.joinedAt());
+        if (due & SCHEDULE_RECORD)
+            _outbox.push(reading(epoch));
+    }
+
+    static Measurement reading(unsigned long epoch)
+    {
+        Measurement m;
+
+        m.temperature = 25.0f + (rand() % 200) / 100.0f;
+        m.ph = 6.8f + (rand() % 40) / 100.0f;
+        m.turbidity = 10.0f + (rand() % 100) / 20.0f;
+        m.dissolvedOxygen = 7.0f + (rand() % 100) / 100.0f;
+        m.epoch = epoch;
+        m.seq = 0;
+        return m;
+    }
+
+    // Deliveries only start in Uplink::poll() and finish one at a time, so deltas are 0 or 1
+    void collect(uint32_t nowMs, FleetMetrics &metrics)
+    {
+        const UplinkStats &s = _uplink.stats();
+
+        if (s.attempts != _attempts)
+        {
+            _attempts = s.attempts;
+            metrics.attempt(nowMs);
+        }
+        if (s.sent != _sent)
+        {
+            _sent = s.sent;
+            metrics.latencies.push_back(s.lastLatencyMs);
+        }
+    }
+
+    char _id[TELEMETRY_ID_SIZE], _name[FLEET_NAME_SIZE];
+    char _email[FLEET_CREDENTIAL_SIZE], _password[FLEET_CREDENTIAL_SIZE];
+    std::string _token;
+    Outbox _outbox;
+    Uplink _uplink;
+    HostWebSocket _socket;
+    RealtimeChannel _channel;
+    HostHttpUplink _http;
+    HostSignIn _signIn;
+    DeviceSchedule _schedule;
+    SignInRetry _signInRetry;
+
+    State _state;
+    bool _syncEnable, _signingIn;
+    uint32_t _bootAtMs, _signInStartedMs;
+    int32_t _clockOffsetMs;
+    uint32_t _attempts, _sent;
+};
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--url URL] [--key KEY] [--devices N] [--duration S] [--speed X] [--ramp S]\n"
+            "          [--skew-ms MS] [--report S] [--seed N] [--encoding json|cbor] [--deflate] [--spread]\n"
+            "          [--transport http|realtime]\n"
+            "URL and KEY default to $AQUA_SUPABASE_HOST and $AQUA_SUPABASE_KEY, then to " FLEET_DEFAULT_URL "\n"
+            "and an empty key. Devices boot across --ramp seconds, their clocks differ by up to --skew-ms\n"
+            "(NTP error), --speed runs the clocks that many times faster than the wall. --transport realtime\n"
+            "broadcasts new rows, which only reach the table with standin.py --ingest-broadcasts.\n",
+            name);
+}
+
+static bool parseOptions(int argc, char **argv, FleetOptions &o)
+{
+    o.url = getenv("AQUA_SUPABASE_HOST") ? getenv("AQUA_SUPABASE_HOST") : FLEET_DEFAULT_URL;
+    o.key = getenv("AQUA_SUPABASE_KEY") ? getenv("AQUA_SUPABASE_KEY") : "";
+    o.devices = 1000;
+    o.durationS = 120;
+    o.speed = 10;
+    o.rampS = 10;
+    o.skewMs = 200;
+    o.reportS = 10;
+    o.seed = 1;
+    o.encoding = ENCODING_JSON;
+    o.transport = TRANSPORT_HTTP;
+    o.deflate = false;
+    o.spread = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (!strcmp(arg, "--deflate"))
+        {
+            o.deflate = true;
+            continue;
+        }
+        if (!strcmp(arg, "--spread"))
+        {
+            o.spread = true;
+            continue;
+        }
+        if (!value)
+            return false;
+        i++;
+
+        if (!strcmp(arg, "--url"))
+            o.url = value;
+        else if (!strcmp(arg, "--key"))
+            o.key = value;
+        else if (!strcmp(arg, "--devices"))
+            o.devices = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--duration"))
+            o.durationS = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--speed"))
+            o.speed = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--ramp"))
+            o.rampS = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--skew-ms"))
+            o.skewMs = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--report"))
+            o.reportS = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--seed"))
+            o.seed = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--encoding") && (!strcmp(value, "json") || !strcmp(value, "cbor")))
+            o.encoding = !strcmp(value, "cbor") ? ENCODING_CBOR : ENCODING_JSON;
+        else if (!strcmp(arg, "--transport") && (!strcmp(value, "http") || !strcmp(value, "realtime")))
+            o.transport = !strcmp(value, "realtime") ? TRANSPORT_REALTIME : TRANSPORT_HTTP;
+        else
+            return false;
+    }
+    return o.devices > 0 && o.speed > 0 && o.reportS > 0;
+}
+
+// Every device needs its sockets open at once
+static bool raiseFileLimit(uint32_t devices)
+{
+    struct rlimit limit;
+    rlim_t needed = (rlim_t)devices * FLEET_FDS_PER_DEVICE + 32;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+        return false;
+    if (limit.rlim_cur < needed)
+    {
+        limit.rlim_cur = std::min(needed, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur < needed)
+    {
+        fprintf(stderr, "fleet: %lu file descriptors allowed, %lu needed, raise the hard limit (ulimit -Hn)\n",
+                (unsigned long)limit.rlim_cur, (unsigned long)needed);
+        return false;
+    }
+    return true;
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, double p)
+{
+    return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+static void report(uint32_t nowMs, const std::vector<std::unique_ptr<VirtualDevice>> &fleet, FleetMetrics &metrics)
+{
+    static uint32_t lastMs, lastAttempts;
+    uint32_t running = 0, joined = 0, pending = 0, dropped = 0, reconnects = 0;
+    uint32_t attempts = 0, sent = 0, failed = 0, timeouts = 0, primary = 0, fallback = 0;
+    struct rusage usage;
+
+    for (const std::unique_ptr<VirtualDevice> &d : fleet)
+    {
+        const UplinkStats &s = d->uplink().stats();
+
+        running += d->running();
+        joined += d->joined();
+        pending += d->outbox().pending();
+        dropped += d->outbox().dropped();
+        reconnects += d->reconnects();
+        attempts += s.attempts;
+        sent += s.sent;
+        failed += s.failed;
+        timeouts += s.timeouts;
+        primary += s.primary;
+        fallback += s.fallback;
+    }
+
+    std::vector<uint32_t> sorted(metrics.latencies);
+    std::sort(sorted.begin(), sorted.end());
+    uint32_t elapsedS = (nowMs - startMs) / 1000;
+    double rate = nowMs != lastMs ? (attempts - lastAttempts) * 1000.0 / (nowMs - (lastMs ? lastMs : startMs)) : 0.0;
+
+    lastMs = nowMs;
+    lastAttempts = attempts;
+
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%5us up %u joined %u signins %u/%u failed | uploads %u ok %u (primary %u fallback %u) fail %u timeout %u "
+           "| %.1f/s | p50 %u p95 %u p99 %u max %u ms | pending %u dropped %u reconnects %u | fds %zu "
+           "arena peak %zu fail %u | rss %ld KB\n",
+           elapsedS, running, joined, metrics.signIns, metrics.signInFailures, attempts, sent, primary, fallback,
+           failed, timeouts, rate, percentile(sorted, 0.50), percentile(sorted, 0.95),
+           percentile(sorted, 0.99), sorted.empty() ? 0 : sorted.back(), pending, dropped, reconnects,
+           HostConnection::openCount(), arena.peak(), arena.failures(), usage.ru_maxrss);
+    fflush(stdout);
+}
+
+static void summary(const FleetOptions &o, FleetMetrics &metrics)
+{
+    uint32_t total = 0, peak = 0, busiest = 0;
+
+    for (uint32_t n : metrics.perSecond)
+    {
+        total += n;
+        peak = std::max(peak, n);
+    }
+    for (uint32_t n : metrics.herd)
+        busiest = std::max(busiest, n);
+
+    printf("\nupload attempts %u over %zu s: mean %.1f/s, peak %u/s (%.1fx mean)\n", total, metrics.perSecond.size(),
+           metrics.perSecond.empty() ? 0.0 : (double)total / metrics.perSecond.size(), peak,
+           total ? peak * (double)metrics.perSecond.size() / total : 0.0);
+    printf("attempts by wall time from the nearest five minute boundary, %s schedule:\n",
+           o.spread ? "spread" : "aligned");
+    for (int i = 0; i < FLEET_HERD_BINS; i++)
+    {
+        int width = busiest ? (int)(50.0 * metrics.herd[i] / busiest + 0.5) : 0;
+        printf("  %+5d ms %7u %.*s\n", i * FLEET_HERD_BIN_MS - FLEET_HERD_LEAD_MS, metrics.herd[i], width,
+               "##################################################");
+    }
+    printf("  elsewhere %5u\n", metrics.outsideHerd);
+}
+
+int main(int argc, char **argv)
+{
+    FleetOptions o;
+    RealtimeEndpoint endpoint;
+    FleetMetrics metrics = {};
+    std::string stats;
+
+    if (!parseOptions(argc, argv, o) || !parseRealtimeEndpoint(o.url, endpoint))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (endpoint.secure)
+    {
+        fprintf(stderr, "fleet: no TLS on the host, point --url at a plain http stack\n");
+        return 2;
+    }
+    if (!raiseFileLimit(o.devices))
+        return 2;
+
+    srand(o.seed);
+    speed = o.speed;
+    startMs = hostMillis();
+    // The first boundary falls a couple of seconds after the last device booted
+    startEpochMs = (FLEET_FIRST_BOUNDARY - (o.rampS + 2) * o.speed) * 1000ULL;
+
+    std::vector<std::unique_ptr<VirtualDevice>> fleet;
+    for (uint32_t i = 0; i < o.devices; i++)
+    {
+        char config[160], user[128];
+        int32_t offset = o.skewMs ? (int32_t)(rand() % (2 * o.skewMs + 1)) - (int32_t)o.skewMs : 0;
+        uint32_t bootAt = startMs + (o.rampS ? (uint32_t)(rand() % (o.rampS * 1000)) : 0);
+
+        // UUIDs that stay the same for a given --seed, so reruns upsert instead of piling up
+        snprintf(config, sizeof(config),
+                 "{\"id\":\"%08x-%04x-4%03x-8%03x-%012x\",\"name\":\"Fleet %u\",\"enable_monitoring\":true}",
+                 o.seed, i >> 16, i & 0xFFF, o.seed & 0xFFF, i, i);
+        snprintf(user, sizeof(user), "{\"email\":\"fleet%u@example.com\",\"password\":\"fleet\"}", i);
+
+        fleet.emplace_back(new VirtualDevice());
+        if (!fleet.back()->begin(config, user, bootAt, offset, o.spread ? rand() % UPLOAD_PERIOD : 0))
+        {
+            fprintf(stderr, "fleet: device %u has an unusable config\n", i);
+            return 2;
+        }
+    }
+
+    printf("fleet: %u devices against %s for %u s, clocks x%u, boot ramp %u s, skew +-%u ms, %s schedule over %s\n",
+           o.devices, o.url, o.durationS, o.speed, o.rampS, o.skewMs, o.spread ? "spread" : "aligned",
+           o.transport == TRANSPORT_REALTIME ? "realtime" : "http");
+
+    uint32_t endMs = startMs + o.durationS * 1000, nextReportMs = startMs + o.reportS * 1000;
+    for (;;)
+    {
+        uint32_t now = hostMillis();
+
+        if ((int32_t)(now - endMs) >= 0)
+            break;
+
+        HostConnection::pollAll(10);
+        now = hostMillis();
+        for (std::unique_ptr<VirtualDevice> &d : fleet)
+            d->loop(now, o, endpoint, metrics);
+
+        if ((int32_t)(now - nextReportMs) >= 0)
+        {
+            report(now, fleet, metrics);
+            nextReportMs += o.reportS * 1000;
+        }
+    }
+    report(hostMillis(), fleet, metrics);
+    summary(o, metrics);
+
+    if (hostRequest(endpoint, "GET", "/stats", o.key, "", stats) == 200)
+        printf("stand-in: %s\n", stats.c_str());
+    printf("aquarium changes seen %u\n", changes);
+    return 0;
+}
@@ -0,0 +1,257 @@
+// Host soak test: `pio run -e soak -t exec`, or `.pio/build/soak/program --duration 3600 ...`
+// Runs the firmware's Outbox, Uplink and RealtimeChannel against tools/standin/standin.py on an
+// accelerated measurement schedule. Reports throughput, failures, latency and memory while it runs,
+// then drains the outbox and checks that the stand-in holds every row that was recorded and not
+// dropped, once.
+//
+// Stand-in only. The host has no TLS, which rules out a Supabase project, and a `supabase start`
+// stack has neither the measurements table (this repo only ships the seq migration on top of it),
+// the soak user it signs in as, nor the /stats it reports. --transport realtime also needs the
+// stand-in started with --ingest-broadcasts, Supabase itself never stores broadcasts.
+#include <ArenaAllocator/ArenaAllocator.h>
+#include <Host/HostNet.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SOAK_DEFAULT_URL "http://127.0.0.1:54321"
+#define SOAK_DRAIN_MS 60000U
+#define SOAK_SIGN_IN_RETRY_MS 5000U
+#define SOAK_FIRST_EPOCH 1733843700UL
+#define SOAK_MEASUREMENT_PERIOD 300 // virtual seconds between rows, the firmware's five minutes
+
+struct SoakOptions
+{
+    const char *url, *key, *email, *password, *id;
+    uint32_t durationS, periodMs, reportS;
+    PayloadEncoding encoding;
+    TelemetryTransport transport;
+    bool deflate;
+};
+
+static uint8_t arenaBuffer[16384];
+static ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+static uint32_t changes;
+
+static void onChange(JsonVariantConst)
+{
+    changes++;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--url URL] [--key KEY] [--email E] [--password P] [--id ENV_ID]\n"
+            "          [--duration S] [--period-ms MS] [--report S] [--encoding json|cbor] [--deflate]\n"
+            "          [--transport http|realtime]\n"
+            "URL is a tools/standin/standin.py instance. URL and KEY default to $AQUA_SUPABASE_HOST and\n"
+            "$AQUA_SUPABASE_KEY, then to " SOAK_DEFAULT_URL " and an empty key (the stand-in accepts\n"
+            "anything). --period-ms is the wall time of one five minute measurement interval.\n"
+            "--transport realtime broadcasts new rows, which only reach the table with standin.py\n"
+            "--ingest-broadcasts.\n",
+            name);
+}
+
+static bool parseOptions(int argc, char **argv, SoakOptions &o)
+{
+    static char id[TELEMETRY_ID_SIZE];
+
+    o.url = getenv("AQUA_SUPABASE_HOST") ? getenv("AQUA_SUPABASE_HOST") : SOAK_DEFAULT_URL;
+    o.key = getenv("AQUA_SUPABASE_KEY") ? getenv("AQUA_SUPABASE_KEY") : "";
+    o.email = "soak@example.com";
+    o.password = "soak";
+    o.durationS = 600;
+    o.periodMs = 1000;
+    o.reportS = 10;
+    o.encoding = ENCODING_JSON;
+    o.transport = TRANSPORT_HTTP;
+    o.deflate = false;
+
+    // A fresh env_id per run keeps the final row count about this run only
+    srand(time(nullptr) ^ getpid());
+    snprintf(id, sizeof(id), "%08x-%04x-4%03x-8%03x-%04x%08x", rand(), rand() & 0xFFFF, rand() & 0xFFF,
+             rand() & 0xFFF, rand() & 0xFFFF, rand());
+    o.id = id;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (!strcmp(arg, "--deflate"))
+        {
+            o.deflate = true;
+            continue;
+        }
+        if (!value)
+            return false;
+        i++;
+
+        if (!strcmp(arg, "--url"))
+            o.url = value;
+        else if (!strcmp(arg, "--key"))
+            o.key = value;
+        else if (!strcmp(arg, "--email"))
+            o.email = value;
+        else if (!strcmp(arg, "--password"))
+            o.password = value;
+        else if (!strcmp(arg, "--id") && strlen(value) < TELEMETRY_ID_SIZE)
+            o.id = value;
+        else if (!strcmp(arg, "--duration"))
+            o.durationS = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--period-ms"))
+            o.periodMs = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--report"))
+            o.reportS = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--encoding") && (!strcmp(value, "json") || !strcmp(value, "cbor")))
+            o.encoding = !strcmp(value, "cbor") ? ENCODING_CBOR : ENCODING_JSON;
+        else if (!strcmp(arg, "--transport") && (!strcmp(value, "http") || !strcmp(value, "realtime")))
+            o.transport = !strcmp(value, "realtime") ? TRANSPORT_REALTIME : TRANSPORT_HTTP;
+        else
+            return false;
+    }
+    return o.periodMs > 0 && o.reportS > 0;
+}
+
+// Plausible readings that drift slowly, so consecutive rows differ
+static Measurement reading(uint32_t n)
+{
+    Measurement m;
+
+    m.temperature = 25.0f + 1.5f * sinf(n / 48.0f);
+    m.ph = 6.8f + 0.2f * sinf(n / 96.0f);
+    m.turbidity = 10.0f + (rand() % 100) / 20.0f;
+    m.dissolvedOxygen = 7.5f - 0.5f * sinf(n / 48.0f);
+    m.epoch = SOAK_FIRST_EPOCH + (unsigned long)n * SOAK_MEASUREMENT_PERIOD;
+    m.seq = 0;
+    return m;
+}
+
+static void report(uint32_t elapsedMs, uint32_t recorded, const Outbox &outbox, const Uplink &uplink,
+                   const RealtimeChannel &channel, const HostWebSocket &socket, const HostHttpUplink &http)
+{
+    const UplinkStats &s = uplink.stats();
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%6.0fs rec %u acked %u (%.1f rows/s) pending %u dropped %u | tries %u ok %u (primary %u fallback %u) "
+           "fail %u timeout %u backoff %us | lat avg %.0f max %u ms | ws %s reconnects %u http %d | "
+           "arena peak %u fail %u | rss %ld KB\n",
+           elapsedMs / 1000.0, recorded, s.rows, elapsedMs ? s.rows * 1000.0 / elapsedMs : 0.0,
+           (unsigned)outbox.pending(), outbox.dropped(), s.attempts, s.sent, s.primary, s.fallback, s.failed,
+           s.timeouts, uplink.backoffMs() / 1000, s.sent ? (double)s.totalLatencyMs / s.sent : 0.0,
+           s.maxLatencyMs, channel.joined() ? "joined" : "down", socket.reconnects(), http.lastStatus(),
+           (unsigned)arena.peak(), arena.failures(), usage.ru_maxrss);
+    fflush(stdout);
+}
+
+// Rows the server holds for this env_id, -1 when they could not be fetched
+static long storedRows(const RealtimeEndpoint &endpoint, const SoakOptions &o)
+{
+    std::string path = "/rest/v1/measurements?select=seq&env_id=eq.", response;
+    long rows = 0;
+
+    path += o.id;
+    if (hostRequest(endpoint, "GET", path.c_str(), o.key, "", response) != 200)
+        return -1;
+    for (size_t at = response.find("\"seq\""); at != std::string::npos; at = response.find("\"seq\"", at + 5))
+        rows++;
+    return rows;
+}
+
+int main(int argc, char **argv)
+{
+    SoakOptions o;
+    RealtimeEndpoint endpoint;
+    std::string token, stats;
+
+    if (!parseOptions(argc, argv, o) || !parseRealtimeEndpoint(o.url, endpoint))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (endpoint.secure)
+    {
+        fprintf(stderr, "soak: no TLS on the host, point --url at a plain http stack\n");
+        return 2;
+    }
+
+    printf("soak: %s as %s for %u s, one interval per %u ms, %s%s over %s\n", o.url, o.id, o.durationS,
+           o.periodMs, o.encoding == ENCODING_CBOR ? "cbor" : "json", o.deflate ? "+deflate" : "",
+           o.transport == TRANSPORT_REALTIME ? "realtime" : "http");
+    while (!hostSignIn(endpoint, o.key, o.email, o.password, token))
+    {
+        fprintf(stderr, "soak: sign-in failed, retrying\n");
+        usleep(SOAK_SIGN_IN_RETRY_MS * 1000);
+    }
+
+    Outbox outbox;
+    Uplink uplink(outbox, o.id, hostMillis);
+    HostWebSocket socket;
+    RealtimeChannel channel(socket, &arena);
+    HostHttpUplink http;
+
+    outbox.begin((uint32_t)time(nullptr));
+    channel.begin(o.id, token.c_str(), onChange);
+    channel.setPresence("soak", "2024-12-10T15:15:00Z");
+    channel.setUplink(&uplink);
+    http.begin(endpoint, o.key, o.encoding, o.deflate, uplink);
+    if (o.transport == TRANSPORT_REALTIME)
+        uplink.setTransports(&channel, &http);
+    else
+        uplink.setTransports(&http, nullptr);
+    socket.begin(endpoint, o.key, channel);
+
+    uint32_t startMs = hostMillis(), endMs = startMs + o.durationS * 1000, drainEndMs = endMs + SOAK_DRAIN_MS;
+    uint32_t nextRowMs = startMs, nextReportMs = startMs + o.reportS * 1000;
+    uint32_t recorded = 0;
+
+    for (;;)
+    {
+        uint32_t now = hostMillis();
+        bool recording = (int32_t)(now - endMs) < 0;
+
+        if (!recording && (outbox.pending() == 0 || (int32_t)(now - drainEndMs) >= 0))
+            break;
+
+        HostConnection::pollAll(10);
+        now = hostMillis();
+        socket.poll(now);
+
+        // Recording never waits for the link, the same as the firmware
+        if (recording && (int32_t)(now - nextRowMs) >= 0)
+        {
+            outbox.push(reading(recorded++));
+            nextRowMs += o.periodMs;
+        }
+        uplink.poll();
+
+        if ((int32_t)(now - nextReportMs) >= 0)
+        {
+            report(now - startMs, recorded, outbox, uplink, channel, socket, http);
+            nextReportMs += o.reportS * 1000;
+        }
+    }
+    report(hostMillis() - startMs, recorded, outbox, uplink, channel, socket, http);
+
+    // Dropped or still pending rows may have reached the server with only their ack lost
+    long expected = (long)recorded - outbox.dropped() - outbox.pending();
+    long stored = storedRows(endpoint, o);
+    printf("soak: recorded %u, dropped %u, pending %u, expected on the server %ld to %u, stored %ld, "
+           "aquarium changes seen %u\n",
+           recorded, outbox.dropped(), (unsigned)outbox.pending(), expected, recorded, stored, changes);
+    if (hostRequest(endpoint, "GET", "/stats", o.key, "", stats) == 200)
+        printf("stand-in: %s\n", stats.c_str());
+
+    if (stored < expected || stored > (long)recorded || arena.failures())
+    {
+        printf("soak: FAILED\n");
+        return 1;
+    }
+    printf("soak: OK\n");
+    return 0;
+}
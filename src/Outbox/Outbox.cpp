@@ -0,0 +1,70 @@
+#include "Outbox.h"
+
+Outbox::Outbox()
+    : _rows(), _first(0), _end(0), _dropped(0), _boot(0)
+{
+}
+
+uint32_t Outbox::push(const Measurement &m)
+{
+    if (_end - _first == OUTBOX_SIZE)
+    {
+        _first++;
+        _dropped++;
+    }
+
+    _rows[_end % OUTBOX_SIZE] = m;
+    _rows[_end % OUTBOX_SIZE].seq = ((uint64_t)_boot << 32) | _end;
+    return _end++;
+}
+
+size_t Outbox::encode(PayloadEncoding encoding, uint8_t *out, size_t len, const char *envId, uint32_t &lastSeq,
+                      size_t maxRows) const
+{
+    size_t rowMax = encoding == ENCODING_CBOR ? CBOR_PAYLOAD_MAX : TELEMETRY_PAYLOAD_SIZE;
+    size_t count = pending();
+    size_t pos, n;
+
+    // Leave room for the array framing, rows are sized by their worst case
+    if (len < 8 || count == 0)
+        return 0;
+    if (count > maxRows)
+        count = maxRows;
+    if (count > (len - 8) / rowMax)
+        count = (len - 8) / rowMax;
+
+    if (encoding == ENCODING_CBOR)
+        pos = encodeCborArray(out, len, count);
+    else
+    {
+        out[0] = '[';
+        pos = 1;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (encoding != ENCODING_CBOR && i > 0)
+            out[pos++] = ',';
+
+        n = encodePayload(encoding, out + pos, len - pos, envId, _rows[(_first + i) % OUTBOX_SIZE]);
+        if (n == 0)
+            return 0;
+        pos += n;
+    }
+
+    if (encoding != ENCODING_CBOR)
+    {
+        out[pos++] = ']';
+        out[pos] = '\0';
+    }
+
+    lastSeq = _first + count - 1;
+    return pos;
+}
+
+void Outbox::ack(uint32_t lastSeq)
+{
+    // Rows dropped while the upload was in flight already moved _first past them
+    if (lastSeq - _first < pending())
+        _first = lastSeq + 1;
+}
@@ -0,0 +1,37 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <PayloadCodec/PayloadCodec.h>
+
+#define OUTBOX_SIZE 16 // measurements held for backfill while the uplink is down
+#define OUTBOX_BATCH_SIZE (OUTBOX_SIZE * TELEMETRY_PAYLOAD_SIZE + 8)
+
+// Measurements waiting for delivery, numbered by a sequence that keeps counting across drops.
+// An upload carries the oldest pending rows, an acknowledged upload retires them.
+// Each row is stamped with seq = boot << 32 | sequence so the server can drop rows it already has.
+class Outbox
+{
+public:
+    Outbox();
+
+    // boot must differ on every power cycle, rows pushed before begin() use boot 0
+    void begin(uint32_t boot) { _boot = boot; }
+    uint32_t push(const Measurement &m);
+    size_t pending() const { return _end - _first; }
+    uint32_t oldest() const { return _first; }
+    uint32_t dropped() const { return _dropped; }
+
+    // Encodes up to maxRows of the oldest pending rows that fit as one batch (JSON array or CBOR array).
+    // lastSeq receives the sequence of the last row included, for ack().
+    size_t encode(PayloadEncoding encoding, uint8_t *out, size_t len, const char *envId, uint32_t &lastSeq,
+                  size_t maxRows = OUTBOX_SIZE) const;
+    void ack(uint32_t lastSeq);
+
+private:
+    Measurement _rows[OUTBOX_SIZE];
+    uint32_t _first, _end; // pending sequences are [_first, _end)
+    uint32_t _dropped;     // pushed out of a full outbox before delivery
+    uint32_t _boot;
+};
+
+#endif
@@ -0,0 +1,343 @@
+#include "PayloadCodec.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define CBOR_UINT 0x00
+#define CBOR_NEGINT 0x20
+#define CBOR_BYTES 0x40
+#define CBOR_TEXT 0x60
+#define CBOR_ARRAY 0x80
+#define CBOR_NULL 0xF6
+
+#define UUID_TEXT_LEN 36
+#define UUID_SIZE 16
+#define ROW_FIELDS 7
+
+size_t formatTimestamp(char *out, size_t len, unsigned long epoch)
+{
+    time_t raw = (time_t)epoch;
+    struct tm t;
+
+    if (len < TELEMETRY_TIMESTAMP_SIZE || gmtime_r(&raw, &t) == nullptr)
+        return 0;
+
+    return strftime(out, len, "%Y-%m-%dT%H:%M:%SZ", &t);
+}
+
+static bool reportable(float value)
+{
+    return isfinite(value) && fabsf(value) < PAYLOAD_VALUE_LIMIT;
+}
+
+// Appends a number (or null when it is not reportable) and a trailing separator, advancing pos
+static bool appendValue(char *out, size_t len, size_t &pos, const char *key, float value, char sep)
+{
+    int n = !reportable(value)
+                ? snprintf(out + pos, len - pos, "\"%s\":null%c", key, sep)
+                : snprintf(out + pos, len - pos, "\"%s\":%.3f%c", key, value, sep);
+
+    if (n < 0 || (size_t)n >= len - pos)
+        return false;
+
+    pos += n;
+    return true;
+}
+
+size_t buildPayload(char *out, size_t len, const char *envId, const Measurement &m)
+{
+    char createdAt[TELEMETRY_TIMESTAMP_SIZE];
+    size_t pos;
+    int n;
+
+    if (!formatTimestamp(createdAt, sizeof(createdAt), m.epoch))
+        return 0;
+
+    n = snprintf(out, len, "{\"env_id\":\"%s\",\"seq\":%llu,", envId, (unsigned long long)m.seq);
+    if (n < 0 || (size_t)n >= len)
+        return 0;
+    pos = n;
+
+    if (!appendValue(out, len, pos, "temp", m.temperature, ',') ||
+        !appendValue(out, len, pos, "dissolved_oxygen", m.dissolvedOxygen, ',') ||
+        !appendValue(out, len, pos, "turbidity", m.turbidity / 100, ',') ||
+        !appendValue(out, len, pos, "ph", m.ph, ','))
+        return 0;
+
+    n = snprintf(out + pos, len - pos, "\"created_at\":\"%s\"}", createdAt);
+    if (n < 0 || (size_t)n >= len - pos)
+        return 0;
+
+    return pos + n;
+}
+
+size_t encodePayload(PayloadEncoding encoding, uint8_t *out, size_t len, const char *envId, const Measurement &m)
+{
+    switch (encoding)
+    {
+    case ENCODING_CBOR:
+        return encodeCborPayload(out, len, envId, m);
+    case ENCODING_JSON:
+    default:
+        return buildPayload((char *)out, len, envId, m);
+    }
+}
+
+const char *payloadContentType(PayloadEncoding encoding)
+{
+    return encoding == ENCODING_CBOR ? "application/cbor" : "application/json";
+}
+
+struct CborWriter
+{
+    uint8_t *out;
+    size_t len, pos;
+    bool ok;
+
+    void put(uint8_t b)
+    {
+        if (pos < len)
+            out[pos++] = b;
+        else
+            ok = false;
+    }
+
+    void head(uint8_t major, uint64_t value)
+    {
+        if (value < 24)
+            put(major | value);
+        else if (value <= 0xFF)
+        {
+            put(major | 24);
+            put(value);
+        }
+        else if (value <= 0xFFFF)
+        {
+            put(major | 25);
+            put(value >> 8);
+            put(value);
+        }
+        else if (value <= 0xFFFFFFFF)
+        {
+            put(major | 26);
+            for (int shift = 24; shift >= 0; shift -= 8)
+                put(value >> shift);
+        }
+        else
+        {
+            put(major | 27);
+            for (int shift = 56; shift >= 0; shift -= 8)
+                put(value >> shift);
+        }
+    }
+
+    void scaled(float value, float scale)
+    {
+        // lroundf is undefined past the range of long, non-finite values never reach it
+        if (!reportable(value))
+        {
+            put(CBOR_NULL);
+            return;
+        }
+
+        long n = lroundf(value * scale);
+        if (n >= 0)
+            head(CBOR_UINT, n);
+        else
+            head(CBOR_NEGINT, -1 - n);
+    }
+
+    void bytes(uint8_t major, const uint8_t *data, size_t n)
+    {
+        head(major, n);
+        for (size_t i = 0; i < n; i++)
+            put(data[i]);
+    }
+};
+
+struct CborReader
+{
+    const uint8_t *in;
+    size_t len, pos;
+
+    bool head(uint8_t &major, uint64_t &value)
+    {
+        if (pos >= len)
+            return false;
+
+        uint8_t b = in[pos++];
+        uint8_t info = b & 0x1F;
+        size_t extra = info < 24 ? 0 : info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : info == 27 ? 8 : 0;
+
+        major = b & 0xE0;
+        if (info > 27 || pos + extra > len)
+            return false;
+
+        value = extra ? 0 : info;
+        while (extra--)
+            value = (value << 8) | in[pos++];
+        return true;
+    }
+
+    bool scaled(float &value, float scale)
+    {
+        uint8_t major;
+        uint64_t n;
+
+        if (pos < len && in[pos] == CBOR_NULL)
+        {
+            pos++;
+            value = NAN;
+            return true;
+        }
+        if (!head(major, n))
+            return false;
+
+        if (major == CBOR_UINT)
+            value = n / scale;
+        else if (major == CBOR_NEGINT)
+            value = (-1 - (float)n) / scale;
+        else
+            return false;
+        return true;
+    }
+};
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool parseUuid(const char *text, uint8_t *uuid)
+{
+    size_t n = 0;
+
+    if (strlen(text) != UUID_TEXT_LEN)
+        return false;
+
+    for (size_t i = 0; i < UUID_TEXT_LEN; i++)
+    {
+        if (i == 8 || i == 13 || i == 18 || i == 23)
+        {
+            if (text[i] != '-')
+                return false;
+            continue;
+        }
+
+        int hi = hexValue(text[i]), lo = hexValue(text[i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        uuid[n++] = (hi << 4) | lo;
+        i++;
+    }
+    return n == UUID_SIZE;
+}
+
+size_t encodeCborPayload(uint8_t *out, size_t len, const char *envId, const Measurement &m)
+{
+    CborWriter w = {out, len, 0, true};
+    uint8_t uuid[UUID_SIZE];
+
+    if (strlen(envId) >= TELEMETRY_ID_SIZE)
+        return 0;
+
+    w.head(CBOR_ARRAY, ROW_FIELDS);
+
+    if (parseUuid(envId, uuid))
+        w.bytes(CBOR_BYTES, uuid, sizeof(uuid));
+    else
+        w.bytes(CBOR_TEXT, (const uint8_t *)envId, strlen(envId));
+
+    w.head(CBOR_UINT, m.seq);
+    w.head(CBOR_UINT, m.epoch);
+    w.scaled(m.temperature, 100);
+    w.scaled(m.dissolvedOxygen, 100);
+    w.scaled(m.turbidity, 10);
+    w.scaled(m.ph, 100);
+
+    return w.ok ? w.pos : 0;
+}
+
+size_t encodeCborArray(uint8_t *out, size_t len, uint32_t count)
+{
+    CborWriter w = {out, len, 0, true};
+
+    w.head(CBOR_ARRAY, count);
+    return w.ok ? w.pos : 0;
+}
+
+static bool decodeRow(CborReader &r, char *envId, size_t envIdLen, Measurement &m)
+{
+    uint8_t major;
+    uint64_t value;
+
+    if (!r.head(major, value) || major != CBOR_ARRAY || value != ROW_FIELDS)
+        return false;
+
+    if (!r.head(major, value) || value > r.len - r.pos)
+        return false;
+
+    if (major == CBOR_BYTES && value == UUID_SIZE)
+    {
+        const uint8_t *u = r.in + r.pos;
+        if (envIdLen <= UUID_TEXT_LEN)
+            return false;
+        snprintf(envId, envIdLen,
+                 "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                 u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7],
+                 u[8], u[9], u[10], u[11], u[12], u[13], u[14], u[15]);
+    }
+    else if (major == CBOR_TEXT && value < envIdLen)
+    {
+        memcpy(envId, r.in + r.pos, value);
+        envId[value] = '\0';
+    }
+    else
+        return false;
+    r.pos += value;
+
+    if (!r.head(major, value) || major != CBOR_UINT)
+        return false;
+    m.seq = value;
+
+    if (!r.head(major, value) || major != CBOR_UINT || value > 0xFFFFFFFF)
+        return false;
+    m.epoch = value;
+
+    return r.scaled(m.temperature, 100) &&
+           r.scaled(m.dissolvedOxygen, 100) &&
+           r.scaled(m.turbidity, 10) &&
+           r.scaled(m.ph, 100);
+}
+
+bool decodeCborPayload(const uint8_t *in, size_t len, char *envId, size_t envIdLen, Measurement &m)
+{
+    CborReader r = {in, len, 0};
+
+    return decodeRow(r, envId, envIdLen, m) && r.pos == len;
+}
+
+size_t decodeCborBatch(const uint8_t *in, size_t len, char *envId, size_t envIdLen, Measurement *rows, size_t maxRows)
+{
+    CborReader r = {in, len, 0};
+    uint8_t major;
+    uint64_t count;
+
+    if (!r.head(major, count) || major != CBOR_ARRAY || count > maxRows)
+        return 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!decodeRow(r, envId, envIdLen, rows[i]))
+            return 0;
+    }
+
+    return r.pos == len ? count : 0;
+}
@@ -0,0 +1,58 @@
+#ifndef PAYLOADCODEC_H
+#define PAYLOADCODEC_H
+
+// Plain C++ only, so an ingest service can compile this file as-is to decode device uploads
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_ID_SIZE 40 // env_id, a UUID or any text up to 39 chars
+#define TELEMETRY_PAYLOAD_SIZE 224
+#define TELEMETRY_TIMESTAMP_SIZE 21 // "YYYY-MM-DDTHH:MM:SSZ"
+// Worst case row: array head, text env_id with a 2 byte head, 64-bit seq, 32-bit epoch, four 32-bit readings
+#define CBOR_PAYLOAD_MAX (1 + 2 + (TELEMETRY_ID_SIZE - 1) + 9 + 5 + 4 * 5)
+// Readings that are not finite or this far out of range are sent as null in every encoding
+#define PAYLOAD_VALUE_LIMIT 1e6f
+
+struct Measurement
+{
+    float temperature;
+    float ph;
+    float turbidity; // percent
+    float dissolvedOxygen;
+    unsigned long epoch; // UTC seconds
+    uint64_t seq;        // boot count << 32 | outbox sequence, unique per env_id so re-sent rows upsert
+};
+
+enum PayloadEncoding
+{
+    ENCODING_JSON,
+    ENCODING_CBOR,
+};
+
+// Formats a UTC epoch as ISO-8601, returns the number of chars written (0 on error)
+size_t formatTimestamp(char *out, size_t len, unsigned long epoch);
+
+// Writes the measurements row JSON into out, returns its length (0 if it does not fit)
+size_t buildPayload(char *out, size_t len, const char *envId, const Measurement &m);
+
+// Encodes in the selected wire format, returns its length (0 if it does not fit)
+size_t encodePayload(PayloadEncoding encoding, uint8_t *out, size_t len, const char *envId, const Measurement &m);
+const char *payloadContentType(PayloadEncoding encoding);
+
+// CBOR row: a 7 element array
+//   [env_id, seq, epoch, temp * 100, dissolved_oxygen * 100, turbidity percent * 10, ph * 100]
+// env_id is a 16 byte string when it is a UUID, a text string otherwise.
+// Readings are integers, null when the reading is NaN, infinite or beyond PAYLOAD_VALUE_LIMIT.
+// Returns 0 for an env_id longer than TELEMETRY_ID_SIZE - 1.
+size_t encodeCborPayload(uint8_t *out, size_t len, const char *envId, const Measurement &m);
+
+// Reverses encodeCborPayload, envId receives the canonical UUID text. Returns false on malformed input.
+bool decodeCborPayload(const uint8_t *in, size_t len, char *envId, size_t envIdLen, Measurement &m);
+
+// A batch is a CBOR array header followed by that many rows
+size_t encodeCborArray(uint8_t *out, size_t len, uint32_t count);
+
+// Decodes up to maxRows rows of a batch (all rows share the device's envId), returns the row count, 0 on error
+size_t decodeCborBatch(const uint8_t *in, size_t len, char *envId, size_t envIdLen, Measurement *rows, size_t maxRows);
+
+#endif
@@ -0,0 +1,134 @@
+#include "Power.h"
+#include <Console/Console.h>
+#include <WiFi.h>
+
+enum RadioState
+{
+    RADIO_OFF,
+    RADIO_AP,
+    RADIO_STA,
+    RADIO_MODEM_SLEEP,
+    RADIO_STATES,
+};
+
+static const char *radioStateNames[RADIO_STATES] = {"off", "ap", "sta", "modem-sleep"};
+static const float radioStateCurrent[RADIO_STATES] = {0, CURRENT_RADIO_AP, CURRENT_RADIO_STA, CURRENT_RADIO_MODEM_SLEEP};
+
+static PowerProfile profile = POWER_PERFORMANCE;
+static uint64_t radioUs[RADIO_STATES];
+static uint64_t idleUs, activeUs;
+static uint64_t idleAtLastUpdate;
+static double activeCharge; // mA*us spent active, the CPU clock changes with the profile
+static unsigned long lastUpdate, apIdleSince;
+static bool apUp = true;
+
+static RadioState radioState()
+{
+    if (apUp)
+        return RADIO_AP;
+    if (WiFi.getMode() == WIFI_OFF)
+        return RADIO_OFF;
+    // Scanning and reconnecting keep the receiver on, modem sleep needs an association
+    if (WiFi.status() != WL_CONNECTED)
+        return RADIO_STA;
+    return WiFi.getSleep() == WIFI_PS_MAX_MODEM ? RADIO_MODEM_SLEEP : RADIO_STA;
+}
+
+static void applyProfile()
+{
+    if (profile == POWER_LOW)
+    {
+        setCpuFrequencyMhz(80);
+        // The driver only honours power save once the AP is gone
+        if (!apUp)
+            WiFi.setSleep(WIFI_PS_MAX_MODEM);
+    }
+    else
+    {
+        setCpuFrequencyMhz(240);
+        WiFi.setSleep(WIFI_PS_MIN_MODEM);
+    }
+}
+
+void powerBegin(PowerProfile initial)
+{
+    profile = initial;
+    lastUpdate = micros();
+    apIdleSince = millis();
+    applyProfile();
+}
+
+void powerSetProfile(PowerProfile next)
+{
+    powerUpdate();
+    profile = next;
+    applyProfile();
+}
+
+PowerProfile powerProfile()
+{
+    return profile;
+}
+
+void powerUpdate()
+{
+    unsigned long now = micros();
+    unsigned long elapsed = now - lastUpdate;
+    uint64_t idleSince = idleUs - idleAtLastUpdate;
+    uint64_t active = elapsed > idleSince ? elapsed - idleSince : 0;
+
+    radioUs[radioState()] += elapsed;
+    activeUs += active;
+    activeCharge += active * (getCpuFrequencyMhz() > 80 ? CURRENT_CPU_240MHZ : CURRENT_CPU_80MHZ);
+    idleAtLastUpdate = idleUs;
+    lastUpdate = now;
+
+    if (!apUp || profile != POWER_LOW)
+        return;
+
+    // Keep the AP while it is the only way to reach the device
+    if (WiFi.softAPgetStationNum() > 0 || WiFi.status() != WL_CONNECTED)
+        apIdleSince = millis();
+    else if (millis() - apIdleSince >= AP_IDLE_TIMEOUT * 1000UL)
+    {
+        Log.println("Provisioning AP idle, shutting it down");
+        WiFi.softAPdisconnect(true);
+        WiFi.mode(WIFI_STA);
+        apUp = false;
+        applyProfile();
+    }
+}
+
+void powerIdle(uint32_t ms, bool keepAwake)
+{
+    if (profile != POWER_LOW || keepAwake || ms == 0)
+        return;
+
+    unsigned long start = micros();
+    delay(ms);
+    idleUs += micros() - start;
+}
+
+void powerPrintReport(Print &out)
+{
+    powerUpdate();
+
+    uint64_t total = activeUs + idleUs;
+    if (total == 0)
+        return;
+
+    double charge = activeCharge + idleUs * CURRENT_CPU_IDLE;
+
+    out.printf("power profile=%s\n", profile == POWER_LOW ? "low" : "performance");
+    out.printf("cpu active=%.1f%% idle=%.1f%%\n", 100.0 * activeUs / total, 100.0 * idleUs / total);
+
+    out.print("radio");
+    for (int i = 0; i < RADIO_STATES; i++)
+    {
+        out.printf(" %s=%.1f%%", radioStateNames[i], 100.0 * radioUs[i] / total);
+        charge += radioUs[i] * radioStateCurrent[i];
+    }
+    out.println();
+
+    out.printf("estimated average current %.1f mA\n", charge / total);
+}
@@ -0,0 +1,40 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+#ifndef AP_IDLE_TIMEOUT
+#define AP_IDLE_TIMEOUT 600 // seconds without a station before the provisioning AP is shut down
+#endif
+
+// Rough ESP32 figures (mA) from the datasheet, good enough to compare profiles against each other
+#define CURRENT_CPU_240MHZ 50.0f
+#define CURRENT_CPU_80MHZ 20.0f
+#define CURRENT_CPU_IDLE 12.0f
+#define CURRENT_RADIO_AP 100.0f
+#define CURRENT_RADIO_STA 95.0f
+#define CURRENT_RADIO_MODEM_SLEEP 15.0f
+
+enum PowerProfile
+{
+    POWER_PERFORMANCE, // always on, as the firmware has always run
+    POWER_LOW,         // 80 MHz and modem sleep once the provisioning AP has timed out
+};
+
+void powerBegin(PowerProfile profile);
+void powerSetProfile(PowerProfile profile);
+PowerProfile powerProfile();
+
+// Once per sample tick: retires an idle provisioning AP and accounts radio residency
+void powerUpdate();
+
+// Waits out the gap until the next sample, idling so the modem can sleep between DTIM beacons.
+// Returns at once when keepAwake is set (the loop has work queued, e.g. a console export) and in
+// POWER_PERFORMANCE. The station stays associated for realtime, so there is no light sleep:
+// POWER_LOW saves through the 80 MHz clock, modem sleep and retiring the provisioning AP.
+void powerIdle(uint32_t ms, bool keepAwake);
+
+// Per-state residency and the average current it adds up to
+void powerPrintReport(Print &out);
+
+#endif
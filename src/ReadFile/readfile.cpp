@@ -1,24 +1,302 @@
 #include "readfile.h"
+#include <Console/Console.h>
+#include <SPIFFS.h>
+#include <Preferences.h>
 
-// Function to read file content into a String
-String readFileToString(const char *path)
+#define TEMP_SUFFIX ".tmp"
+#define BACKUP_SUFFIX ".bak"
+#define MAX_PATH 32
+#define MIGRATE_NAMESPACE "fsmigrate"
+
+// Forwards to a file while keeping a running CRC32 of everything written
+class ChecksumPrint : public Print
+{
+public:
+    ChecksumPrint(File &file) : _file(file), _crc(0) {}
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        size_t written = _file.write(buffer, size);
+        _crc = crc32Update(_crc, buffer, written);
+        return written;
+    }
+
+    uint32_t checksum() const { return _crc; }
+
+private:
+    File &_file;
+    uint32_t _crc;
+};
+
+static bool withSuffix(char *out, const char *path, const char *suffix)
+{
+    int n = snprintf(out, MAX_PATH, "%s%s", path, suffix);
+    return n > 0 && n < MAX_PATH;
+}
+
+// Checks a file against its checksum trailer, bodyLen receives the length without it
+static Crc32Trailer verifyFile(File &file, size_t &bodyLen)
+{
+    uint8_t buffer[128];
+    char trailer[CRC32_TRAILER_SIZE];
+    size_t size = file.size();
+    uint32_t expected, crc = 0;
+
+    bodyLen = size;
+    if (size < CRC32_TRAILER_SIZE || !file.seek(size - CRC32_TRAILER_SIZE) ||
+        file.read((uint8_t *)trailer, sizeof(trailer)) != sizeof(trailer) || !crc32ParseTrailer(trailer, expected))
+    {
+        file.seek(0);
+        return CRC32_TRAILER_MISSING;
+    }
+
+    bodyLen = size - CRC32_TRAILER_SIZE;
+    file.seek(0);
+    for (size_t left = bodyLen; left > 0;)
+    {
+        size_t n = file.read(buffer, left < sizeof(buffer) ? left : sizeof(buffer));
+        if (n == 0)
+            return CRC32_TRAILER_MISMATCH;
+        crc = crc32Update(crc, buffer, n);
+        left -= n;
+    }
+    file.seek(0);
+
+    return crc == expected ? CRC32_TRAILER_OK : CRC32_TRAILER_MISMATCH;
+}
+
+static String readWholeFile(fs::FS &fs, const char *path)
 {
-    File file = SPIFFS.open(path, FILE_READ);
+    File file = fs.open(path, FILE_READ);
+    size_t bodyLen;
+
     if (!file || file.isDirectory())
     {
         return String();
     }
 
+    if (verifyFile(file, bodyLen) == CRC32_TRAILER_MISMATCH)
+    {
+        Log.printf("%s failed its checksum\n", path);
+        file.close();
+        return String();
+    }
+
     String content;
-    while (file.available())
+    content.reserve(bodyLen);
+    while (content.length() < bodyLen)
     {
-        content += (char)file.read();
+        char buffer[128];
+        size_t left = bodyLen - content.length();
+        size_t n = file.readBytes(buffer, left < sizeof(buffer) ? left : sizeof(buffer));
+        if (n == 0)
+            break;
+        content.concat(buffer, n);
     }
     file.close();
     return content;
 }
 
+// Function to read file content into a String
+String readFileToString(const char *path)
+{
+    char backup[MAX_PATH];
+    String content = readWholeFile(LittleFS, path);
+
+    if (content.isEmpty() && withSuffix(backup, path, BACKUP_SUFFIX))
+        content = readWholeFile(LittleFS, backup);
+
+    return content;
+}
+
+static DeserializationError parseFile(const char *path, JsonDocument &doc)
+{
+    File file = LittleFS.open(path, FILE_READ);
+    size_t bodyLen;
+
+    if (!file || file.isDirectory() || file.size() == 0)
+        return DeserializationError::EmptyInput;
+
+    if (verifyFile(file, bodyLen) == CRC32_TRAILER_MISMATCH)
+    {
+        Log.printf("%s failed its checksum\n", path);
+        file.close();
+        return DeserializationError::InvalidInput;
+    }
+
+    // The parser stops at the end of the document, the trailer after it is never read
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    return error;
+}
+
+DeserializationError readJsonFile(const char *path, JsonDocument &doc)
+{
+    char backup[MAX_PATH];
+    DeserializationError error = parseFile(path, doc);
+
+    if (!error || !withSuffix(backup, path, BACKUP_SUFFIX))
+        return error;
+
+    if (!parseFile(backup, doc))
+    {
+        Log.printf("%s unreadable, using last known good copy\n", path);
+        return DeserializationError::Ok;
+    }
+
+    return error;
+}
+
+bool writeJsonFile(const char *path, JsonVariantConst json)
+{
+    char temp[MAX_PATH], backup[MAX_PATH], trailer[CRC32_TRAILER_SIZE + 1];
+    size_t expectedSize, writtenSize = 0;
+    bool complete;
+
+    if (!withSuffix(temp, path, TEMP_SUFFIX) || !withSuffix(backup, path, BACKUP_SUFFIX))
+        return false;
+
+    File file = LittleFS.open(temp, FILE_WRITE);
+    if (!file)
+        return false;
+
+    ChecksumPrint out(file);
+    expectedSize = serializeJson(json, out);
+    crc32FormatTrailer(trailer, out.checksum());
+    complete = file.write((const uint8_t *)trailer, CRC32_TRAILER_SIZE) == CRC32_TRAILER_SIZE;
+    file.close();
+
+    // Read the temp file back so a short write never replaces a good config
+    file = LittleFS.open(temp, FILE_READ);
+    complete = complete && file && verifyFile(file, writtenSize) == CRC32_TRAILER_OK;
+    file.close();
+
+    if (expectedSize == 0 || !complete || writtenSize != expectedSize)
+    {
+        LittleFS.remove(temp);
+        return false;
+    }
+
+    if (LittleFS.exists(path))
+    {
+        LittleFS.remove(backup);
+        if (!LittleFS.rename(path, backup))
+        {
+            LittleFS.remove(temp);
+            return false;
+        }
+    }
+
+    return LittleFS.rename(temp, path);
+}
+
+// The config files carried over when a SPIFFS image is found on the partition. Web assets
+// are not kept, they come back with `pio run -t uploadfs`.
+static const char *const migratedFiles[] = {"/wifi.json", "/aquarium.json", "/user.json", "/environment.json"};
+
+// Copies the configs out of SPIFFS into NVS, which survives the LittleFS format. The
+// pending flag is written last so a half-finished copy is never restored.
+static bool stashSpiffsConfigs()
+{
+    Preferences stash;
+    char key[4];
+
+    if (!stash.begin(MIGRATE_NAMESPACE, false))
+        return false;
+
+    stash.clear();
+    for (size_t i = 0; i < sizeof(migratedFiles) / sizeof(migratedFiles[0]); i++)
+    {
+        String content = readWholeFile(SPIFFS, migratedFiles[i]);
+
+        snprintf(key, sizeof(key), "f%u", (unsigned)i);
+        if (!content.isEmpty() && stash.putBytes(key, content.c_str(), content.length()) != content.length())
+        {
+            stash.end();
+            return false;
+        }
+    }
+
+    bool ok = stash.putBool("pending", true);
+    stash.end();
+    return ok;
+}
+
+// Writes the stashed configs into the fresh LittleFS, then forgets them
+static void restoreStashedConfigs()
+{
+    Preferences stash;
+    char key[4];
+
+    if (!stash.begin(MIGRATE_NAMESPACE, false))
+        return;
+
+    for (size_t i = 0; i < sizeof(migratedFiles) / sizeof(migratedFiles[0]); i++)
+    {
+        snprintf(key, sizeof(key), "f%u", (unsigned)i);
+        size_t len = stash.getBytesLength(key);
+        if (len == 0)
+            continue;
+
+        uint8_t *content = (uint8_t *)malloc(len);
+        if (content == nullptr)
+            continue;
+
+        stash.getBytes(key, content, len);
+        File file = LittleFS.open(migratedFiles[i], FILE_WRITE);
+        if (file && file.write(content, len) == len)
+            Log.printf("Migrated %s\n", migratedFiles[i]);
+        file.close();
+        free(content);
+    }
+
+    stash.clear();
+    stash.end();
+}
+
+static bool migrationPending()
+{
+    Preferences stash;
+
+    if (!stash.begin(MIGRATE_NAMESPACE, true))
+        return false;
+
+    bool pending = stash.getBool("pending", false);
+    stash.end();
+    return pending;
+}
+
 bool readFileInit()
 {
-    return SPIFFS.begin(true);
-}
\ No newline at end of file
+    // A migration interrupted after the stash finishes on this boot, whatever state the partition is in
+    if (!migrationPending())
+    {
+        if (LittleFS.begin(false))
+            return true;
+
+        // Not LittleFS: a device flashed before the switch still carries a SPIFFS image
+        if (SPIFFS.begin(false))
+        {
+            Log.println("Migrating SPIFFS to LittleFS");
+            bool stashed = stashSpiffsConfigs();
+            SPIFFS.end();
+            if (!stashed)
+            {
+                Log.println("Could not stash the configs, SPIFFS left untouched");
+                return false;
+            }
+        }
+    }
+
+    if (!LittleFS.begin(true))
+        return false;
+
+    if (migrationPending())
+        restoreStashedConfigs();
+    return true;
+}
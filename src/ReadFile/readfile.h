@@ -2,10 +2,21 @@
 #define READFILE_H
 
 #include <Arduino.h>
-#include <SPIFFS.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <Crc32/Crc32.h>
 
+// Mounts LittleFS, carrying the configs over from a SPIFFS image left by older firmware
 bool readFileInit();
 
+// Reads a file, falling back to its last-known-good copy when the file is missing or fails its checksum
 String readFileToString(const char *path);
 
+// Parses a JSON file, falling back to its last-known-good copy when the file is missing or corrupt
+DeserializationError readJsonFile(const char *path, JsonDocument &doc);
+
+// Writes through a verified temp file and an atomic rename, keeping the previous version as a backup.
+// The file ends with a CRC32 trailer (see Crc32.h) that the readers check.
+bool writeJsonFile(const char *path, JsonVariantConst json);
+
 #endif
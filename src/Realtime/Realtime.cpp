@@ -0,0 +1,176 @@
+#include "Realtime.h"
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <Console/Console.h>
+
+Realtime::Realtime()
+    : _channel(nullptr), _allocator(nullptr), _endpoint(), _url(), _apiKey(), _email(), _password(), _token(),
+      _refresh(), _signIn(), _opened(false), _connected(false), _refreshAtMs(0)
+{
+}
+
+bool Realtime::begin(const char *url, const char *apiKey, const char *email, const char *password,
+                     RealtimeChannel &channel, ArduinoJson::Allocator *allocator)
+{
+    if (!parseRealtimeEndpoint(url, _endpoint))
+    {
+        Log.printf("Realtime: unsupported project URL %s\n", url);
+        return false;
+    }
+
+    strlcpy(_url, url, sizeof(_url));
+    strlcpy(_apiKey, apiKey, sizeof(_apiKey));
+    strlcpy(_email, email, sizeof(_email));
+    strlcpy(_password, password, sizeof(_password));
+    _channel = &channel;
+    _allocator = allocator;
+    _signIn.begin(millis());
+    return true;
+}
+
+bool Realtime::requestToken(const char *grant, const char *body, size_t len)
+{
+    HTTPClient http;
+    char url[REALTIME_URL_SIZE + 48];
+    int status;
+
+    snprintf(url, sizeof(url), "%s/auth/v1/token?grant_type=%s", _url, grant);
+    http.begin(url);
+    http.addHeader("apikey", _apiKey);
+    http.addHeader("Content-Type", "application/json");
+    status = http.POST((uint8_t *)body, len);
+    if (status != 200)
+    {
+        Log.printf("Realtime: %s sign-in failed (%d)\n", grant, status);
+        http.end();
+        return false;
+    }
+
+    JsonDocument filter(_allocator);
+    filter["access_token"] = true;
+    filter["refresh_token"] = true;
+    filter["expires_in"] = true;
+
+    JsonDocument doc(_allocator);
+    DeserializationError error = deserializeJson(doc, http.getString(), DeserializationOption::Filter(filter));
+    http.end();
+
+    const char *token = doc["access_token"] | "";
+    if (error || !token[0] || strlen(token) >= sizeof(_token))
+    {
+        Log.println("Realtime: unusable token response");
+        return false;
+    }
+
+    strlcpy(_token, token, sizeof(_token));
+    strlcpy(_refresh, doc["refresh_token"] | "", sizeof(_refresh));
+
+    uint32_t expiresIn = doc["expires_in"] | 3600U;
+    _refreshAtMs = millis() + (expiresIn > 2 * REALTIME_TOKEN_MARGIN ? expiresIn - REALTIME_TOKEN_MARGIN : expiresIn / 2) * 1000;
+    return true;
+}
+
+bool Realtime::login()
+{
+    char body[2 * REALTIME_CREDENTIAL_SIZE + 32];
+    JsonDocument doc(_allocator);
+
+    doc["email"] = (const char *)_email;
+    doc["password"] = (const char *)_password;
+    return requestToken("password", body, serializeJson(doc, body, sizeof(body)));
+}
+
+bool Realtime::refresh()
+{
+    char body[REALTIME_REFRESH_SIZE + 24];
+    JsonDocument doc(_allocator);
+
+    if (!_refresh[0])
+        return login();
+
+    doc["refresh_token"] = (const char *)_refresh;
+    return requestToken("refresh_token", body, serializeJson(doc, body, sizeof(body))) || login();
+}
+
+void Realtime::open()
+{
+    char path[sizeof(REALTIME_PATH) + REALTIME_KEY_SIZE + 32];
+
+    snprintf(path, sizeof(path), REALTIME_PATH "?apikey=%s&vsn=1.0.0", _apiKey);
+    _ws.onEvent([this](WStype_t type, uint8_t *payload, size_t length)
+                { onEvent(type, payload, length); });
+    _ws.setReconnectInterval(REALTIME_RECONNECT_MS);
+
+    if (_endpoint.secure)
+        _ws.beginSSL(_endpoint.host, _endpoint.port, path);
+    else
+        _ws.begin(_endpoint.host, _endpoint.port, path);
+    _opened = true;
+}
+
+void Realtime::loop()
+{
+    uint32_t now = millis();
+
+    if (!_channel)
+        return;
+
+    // Nothing happens without WiFi, WebSocketsClient retries by itself once the socket was opened
+    if (!_opened)
+    {
+        if (WiFi.status() != WL_CONNECTED || !_signIn.due(now))
+            return;
+        if (!login())
+        {
+            _signIn.failed(now);
+            return;
+        }
+        open();
+    }
+
+    _ws.loop();
+    _channel->poll(millis());
+
+    if (_connected && !_channel->healthy())
+    {
+        Log.println("Realtime: heartbeat unanswered, reconnecting");
+        _ws.disconnect();
+    }
+
+    if (WiFi.status() == WL_CONNECTED && (int32_t)(millis() - _refreshAtMs) >= 0)
+    {
+        if (refresh())
+            _channel->accessTokenChanged();
+        else
+            _refreshAtMs = millis() + SIGN_IN_RETRY_MS;
+    }
+}
+
+bool Realtime::sendText(const char *text, size_t len)
+{
+    return _connected && _ws.sendTXT((const uint8_t *)text, len);
+}
+
+void Realtime::onEvent(WStype_t type, uint8_t *payload, size_t length)
+{
+    switch (type)
+    {
+    case WStype_CONNECTED:
+        _connected = true;
+        _channel->connected(millis());
+        break;
+    case WStype_DISCONNECTED:
+        if (_connected)
+        {
+            _connected = false;
+            _channel->disconnected();
+            Log.println("Realtime: disconnected");
+        }
+        break;
+    case WStype_TEXT:
+        _channel->received((const char *)payload, length, millis());
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <Arduino.h>
+#include <WebSocketsClient.h>
+#include <Schedule/Schedule.h>
+#include "RealtimeChannel.h"
+
+#define REALTIME_URL_SIZE 96
+#define REALTIME_KEY_SIZE 256
+#define REALTIME_CREDENTIAL_SIZE 64
+#define REALTIME_TOKEN_SIZE 1200    // GoTrue access tokens are JWTs of roughly 600-1000 chars
+#define REALTIME_REFRESH_SIZE 128
+#define REALTIME_RECONNECT_MS 5000U
+#define REALTIME_TOKEN_MARGIN 300U // s before expiry the session is refreshed
+
+// The websocket and GoTrue session behind a RealtimeChannel. Signs in once WiFi is up,
+// only then opens the socket, reopens it when it drops and refreshes the token before it expires.
+class Realtime : public RealtimeSocket
+{
+public:
+    Realtime();
+
+    // url is the project URL: https://<ref>.supabase.co, or http://host:port for a local stack.
+    // Strings are copied, the channel and allocator are kept.
+    bool begin(const char *url, const char *apiKey, const char *email, const char *password,
+               RealtimeChannel &channel, ArduinoJson::Allocator *allocator);
+    void loop();
+
+    // Stays valid for the life of the object, the channel joins with it
+    const char *accessToken() const { return _token; }
+    bool connected() const { return _connected; }
+
+    bool sendText(const char *text, size_t len) override;
+
+private:
+    bool requestToken(const char *grant, const char *body, size_t len);
+    bool login();
+    bool refresh();
+    void open();
+    void onEvent(WStype_t type, uint8_t *payload, size_t length);
+
+    WebSocketsClient _ws;
+    RealtimeChannel *_channel;
+    ArduinoJson::Allocator *_allocator;
+    RealtimeEndpoint _endpoint;
+    char _url[REALTIME_URL_SIZE], _apiKey[REALTIME_KEY_SIZE];
+    char _email[REALTIME_CREDENTIAL_SIZE], _password[REALTIME_CREDENTIAL_SIZE];
+    char _token[REALTIME_TOKEN_SIZE], _refresh[REALTIME_REFRESH_SIZE];
+    SignInRetry _signIn;
+    bool _opened, _connected;
+    uint32_t _refreshAtMs;
+};
+
+#endif
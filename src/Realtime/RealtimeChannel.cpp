@@ -0,0 +1,307 @@
+#include "RealtimeChannel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Single threaded: every channel serializes into the same buffer and sends it right away
+static char message[REALTIME_MESSAGE_SIZE];
+
+bool parseRealtimeEndpoint(const char *url, RealtimeEndpoint &endpoint)
+{
+    const char *host, *end, *colon;
+    size_t hostLen;
+    long port;
+
+    if (strncmp(url, "https://", 8) == 0 || strncmp(url, "wss://", 6) == 0)
+        endpoint.secure = true;
+    else if (strncmp(url, "http://", 7) == 0 || strncmp(url, "ws://", 5) == 0)
+        endpoint.secure = false;
+    else
+        return false;
+
+    host = strstr(url, "://") + 3;
+    end = host + strcspn(host, "/?");
+    colon = (const char *)memchr(host, ':', end - host);
+    hostLen = (colon ? colon : end) - host;
+    if (hostLen == 0 || hostLen >= sizeof(endpoint.host))
+        return false;
+
+    if (colon)
+    {
+        char *portEnd;
+        port = strtol(colon + 1, &portEnd, 10);
+        if (portEnd != end || port <= 0 || port > 0xFFFF)
+            return false;
+    }
+    else
+        port = endpoint.secure ? 443 : 80;
+
+    memcpy(endpoint.host, host, hostLen);
+    endpoint.host[hostLen] = '\0';
+    endpoint.port = port;
+    return true;
+}
+
+// Phoenix sends refs as strings, null for server pushes
+static uint32_t refOf(JsonVariantConst ref)
+{
+    if (ref.is<const char *>())
+        return strtoul(ref.as<const char *>(), nullptr, 10);
+    return ref.as<uint32_t>();
+}
+
+static void setRef(JsonDocument &doc, const char *key, uint32_t ref)
+{
+    char text[11];
+
+    snprintf(text, sizeof(text), "%lu", (unsigned long)ref);
+    doc[key] = text; // copied, the buffer is gone before serializing
+}
+
+RealtimeChannel::RealtimeChannel(RealtimeSocket &socket, ArduinoJson::Allocator *allocator)
+    : _socket(socket), _allocator(allocator), _uplink(nullptr), _onChange(nullptr), _accessToken(nullptr),
+      _name(nullptr), _joinedAt(nullptr), _topic(), _filter(), _state(CHANNEL_CLOSED), _trackDue(false),
+      _stale(false), _ref(0), _joinRef(0), _heartbeatRef(0), _broadcastRef(0), _broadcastSeq(0), _heartbeatAtMs(0),
+      _rejoinAtMs(0)
+{
+}
+
+void RealtimeChannel::begin(const char *aquariumId, const char *accessToken, RealtimeChangeHandler onChange)
+{
+    snprintf(_topic, sizeof(_topic), "realtime:aquarium:%s", aquariumId);
+    snprintf(_filter, sizeof(_filter), "id=eq.%s", aquariumId);
+    _accessToken = accessToken;
+    _onChange = onChange;
+}
+
+void RealtimeChannel::setPresence(const char *name, const char *joinedAt)
+{
+    _name = name;
+    _joinedAt = joinedAt;
+    _trackDue = joined();
+}
+
+void RealtimeChannel::accessTokenChanged()
+{
+    if (!joined() || !_accessToken)
+        return;
+
+    JsonDocument doc(_allocator);
+    doc["topic"] = (const char *)_topic;
+    doc["event"] = "access_token";
+    doc["payload"]["access_token"] = _accessToken;
+    setRef(doc, "ref", nextRef());
+    setRef(doc, "join_ref", _joinRef);
+    send(doc);
+}
+
+void RealtimeChannel::connected(uint32_t nowMs)
+{
+    _heartbeatRef = 0;
+    _stale = false;
+    _heartbeatAtMs = nowMs + REALTIME_HEARTBEAT_MS;
+    join(nowMs);
+}
+
+void RealtimeChannel::disconnected()
+{
+    failed(0);
+    _state = CHANNEL_CLOSED;
+    _heartbeatRef = 0;
+    _stale = false;
+}
+
+void RealtimeChannel::failed(uint32_t nowMs)
+{
+    if (_broadcastRef)
+    {
+        _broadcastRef = 0;
+        if (_uplink)
+            _uplink->complete(this, _broadcastSeq, false);
+    }
+
+    _state = CHANNEL_ERRORED;
+    _rejoinAtMs = nowMs + REALTIME_REJOIN_MS;
+}
+
+void RealtimeChannel::join(uint32_t nowMs)
+{
+    JsonDocument doc(_allocator);
+
+    // Joins that get no reply are retried like refused ones
+    _rejoinAtMs = nowMs + 2 * REALTIME_REJOIN_MS;
+
+    doc["topic"] = (const char *)_topic;
+    doc["event"] = "phx_join";
+
+    JsonObject payload = doc["payload"].to<JsonObject>();
+    JsonObject config = payload["config"].to<JsonObject>();
+    config["broadcast"]["ack"] = true;
+    config["broadcast"]["self"] = false;
+    config["presence"]["key"] = (const char *)(_filter + 6); // the aquarium id
+    JsonObject changes = config["postgres_changes"].to<JsonArray>().add<JsonObject>();
+    changes["event"] = "UPDATE";
+    changes["schema"] = "public";
+    changes["table"] = "aquarium";
+    changes["filter"] = (const char *)_filter;
+    if (_accessToken)
+        payload["access_token"] = _accessToken;
+
+    _joinRef = nextRef();
+    setRef(doc, "ref", _joinRef);
+    setRef(doc, "join_ref", _joinRef);
+
+    _state = send(doc) ? CHANNEL_JOINING : CHANNEL_ERRORED;
+}
+
+void RealtimeChannel::track()
+{
+    JsonDocument doc(_allocator);
+
+    _trackDue = false;
+    if (!_name)
+        return;
+
+    doc["topic"] = (const char *)_topic;
+    doc["event"] = "presence";
+
+    JsonObject payload = doc["payload"].to<JsonObject>();
+    payload["type"] = "presence";
+    payload["event"] = "track";
+    payload["payload"]["name"] = _name;
+    if (_joinedAt && _joinedAt[0])
+        payload["payload"]["joined_at"] = _joinedAt;
+
+    setRef(doc, "ref", nextRef());
+    setRef(doc, "join_ref", _joinRef);
+    send(doc);
+}
+
+void RealtimeChannel::heartbeat()
+{
+    JsonDocument doc(_allocator);
+
+    doc["topic"] = "phoenix";
+    doc["event"] = "heartbeat";
+    doc["payload"].to<JsonObject>();
+    _heartbeatRef = nextRef();
+    setRef(doc, "ref", _heartbeatRef);
+    send(doc);
+}
+
+void RealtimeChannel::poll(uint32_t nowMs)
+{
+    if (_state == CHANNEL_CLOSED)
+        return;
+
+    if ((int32_t)(nowMs - _heartbeatAtMs) >= 0)
+    {
+        // The previous heartbeat is still unanswered, the socket is dead
+        if (_heartbeatRef)
+            _stale = true;
+        else
+        {
+            _heartbeatAtMs = nowMs + REALTIME_HEARTBEAT_MS;
+            heartbeat();
+        }
+    }
+
+    if ((_state == CHANNEL_ERRORED || _state == CHANNEL_JOINING) && (int32_t)(nowMs - _rejoinAtMs) >= 0)
+        join(nowMs);
+    else if (_state == CHANNEL_JOINED && _trackDue)
+        track();
+}
+
+void RealtimeChannel::received(const char *text, size_t len, uint32_t nowMs)
+{
+    JsonDocument doc(_allocator);
+    const JsonDocument &in = doc;
+
+    if (deserializeJson(doc, text, len))
+        return;
+
+    const char *event = in["event"] | "";
+    const char *topic = in["topic"] | "";
+    uint32_t ref = refOf(in["ref"]);
+
+    if (strcmp(event, "phx_reply") == 0)
+    {
+        bool ok = strcmp(in["payload"]["status"] | "", "ok") == 0;
+
+        if (_heartbeatRef && ref == _heartbeatRef)
+            _heartbeatRef = 0;
+        else if (ref == _joinRef && _state == CHANNEL_JOINING)
+        {
+            if (ok)
+            {
+                _state = CHANNEL_JOINED;
+                _trackDue = true;
+            }
+            else
+                failed(nowMs);
+        }
+        else if (_broadcastRef && ref == _broadcastRef)
+        {
+            _broadcastRef = 0;
+            if (_uplink)
+                _uplink->complete(this, _broadcastSeq, ok);
+        }
+        return;
+    }
+
+    if (strcmp(topic, _topic) != 0)
+        return;
+
+    if (strcmp(event, "postgres_changes") == 0)
+    {
+        if (_onChange)
+            _onChange(in["payload"]["data"]);
+    }
+    else if (strcmp(event, "phx_error") == 0 || strcmp(event, "phx_close") == 0)
+        failed(nowMs);
+}
+
+DeliveryResult RealtimeChannel::deliver(const Outbox &outbox, const char *envId, uint32_t &lastSeq)
+{
+    // Room for one row and its array brackets, broadcasts never carry a backlog
+    uint8_t rows[TELEMETRY_PAYLOAD_SIZE + 8];
+    size_t n = outbox.encode(ENCODING_JSON, rows, sizeof(rows), envId, lastSeq, 1);
+    uint32_t ref;
+
+    if (n == 0 || !ready())
+        return DELIVERY_FAILED;
+
+    JsonDocument doc(_allocator);
+    doc["topic"] = (const char *)_topic;
+    doc["event"] = "broadcast";
+
+    JsonObject payload = doc["payload"].to<JsonObject>();
+    payload["type"] = "broadcast";
+    payload["event"] = REALTIME_BROADCAST_EVENT;
+    payload["payload"]["rows"] = serialized((const char *)rows, n);
+
+    ref = nextRef();
+    setRef(doc, "ref", ref);
+    setRef(doc, "join_ref", _joinRef);
+    if (!send(doc))
+        return DELIVERY_FAILED;
+
+    _broadcastRef = ref;
+    _broadcastSeq = lastSeq;
+    return DELIVERY_PENDING;
+}
+
+bool RealtimeChannel::send(JsonDocument &doc)
+{
+    size_t n;
+
+    if (doc.overflowed())
+        return false;
+
+    n = measureJson(doc);
+    if (n >= sizeof(message))
+        return false;
+
+    serializeJson(doc, message, sizeof(message));
+    return _socket.sendText(message, n);
+}
@@ -0,0 +1,102 @@
+#ifndef REALTIMECHANNEL_H
+#define REALTIMECHANNEL_H
+
+// Supabase Realtime (Phoenix channel protocol, vsn 1.0.0) over any websocket.
+// Plain C++ and ArduinoJson only: the firmware wraps it around WebSocketsClient, the host harnesses
+// around their own sockets.
+#include <ArduinoJson.h>
+#include <Uplink/Uplink.h>
+
+#define REALTIME_HEARTBEAT_MS 25000U // Phoenix closes sockets silent for 60 s
+#define REALTIME_REJOIN_MS 5000U
+#define REALTIME_MESSAGE_SIZE 2048 // join carries the access token, a JWT of up to ~1 KB
+#define REALTIME_TOPIC_SIZE (sizeof("realtime:aquarium:") + TELEMETRY_ID_SIZE)
+#define REALTIME_FILTER_SIZE (sizeof("id=eq.") + TELEMETRY_ID_SIZE)
+#define REALTIME_HOST_SIZE 64
+#define REALTIME_PATH "/realtime/v1/websocket"
+#define REALTIME_BROADCAST_EVENT "measurement"
+
+// Where a project URL puts the realtime socket: https://ref.supabase.co is wss on 443,
+// http://192.168.1.10:54321 (supabase start, or tools/standin) is plain ws on the given port
+struct RealtimeEndpoint
+{
+    char host[REALTIME_HOST_SIZE];
+    uint16_t port;
+    bool secure;
+};
+
+bool parseRealtimeEndpoint(const char *url, RealtimeEndpoint &endpoint);
+
+class RealtimeSocket
+{
+public:
+    virtual ~RealtimeSocket() {}
+
+    virtual bool sendText(const char *text, size_t len) = 0;
+};
+
+// Receives the `data` object of a postgres_changes message ({"record": {...}, "old_record": ...})
+typedef void (*RealtimeChangeHandler)(JsonVariantConst data);
+
+// One channel per device, realtime:aquarium:<id>, joined with
+//   - postgres_changes for UPDATEs of its aquarium row
+//   - presence, tracking {name, joined_at}
+//   - broadcast with ack, which carries measurement rows as {"rows": [row]}
+// Broadcasts are not stored by Supabase, an ingest subscriber on the same topic upserts the rows.
+class RealtimeChannel : public UplinkTransport
+{
+public:
+    RealtimeChannel(RealtimeSocket &socket, ArduinoJson::Allocator *allocator);
+
+    // All strings are kept by pointer and must outlive the channel
+    void begin(const char *aquariumId, const char *accessToken, RealtimeChangeHandler onChange);
+    void setPresence(const char *name, const char *joinedAt);
+    void setUplink(Uplink *uplink) { _uplink = uplink; }
+    // Call after the buffer passed to begin() was refreshed, a joined channel forwards the new token
+    void accessTokenChanged();
+
+    // Socket events
+    void connected(uint32_t nowMs);
+    void disconnected();
+    void received(const char *text, size_t len, uint32_t nowMs);
+    // Heartbeats, rejoins and the presence track after a join
+    void poll(uint32_t nowMs);
+
+    bool joined() const { return _state == CHANNEL_JOINED; }
+    // False once a heartbeat went unanswered for a whole interval, the socket should be reopened
+    bool healthy() const { return !_stale; }
+
+    bool ready() override { return joined() && !_broadcastRef; }
+    size_t capacity() const override { return 1; }
+    DeliveryResult deliver(const Outbox &outbox, const char *envId, uint32_t &lastSeq) override;
+
+private:
+    enum State
+    {
+        CHANNEL_CLOSED, // no socket
+        CHANNEL_JOINING, // rejoin at _rejoinAtMs without a reply
+        CHANNEL_JOINED,
+        CHANNEL_ERRORED, // rejoin at _rejoinAtMs
+    };
+
+    void join(uint32_t nowMs);
+    void track();
+    void heartbeat();
+    void failed(uint32_t nowMs);
+    uint32_t nextRef() { return ++_ref ? _ref : ++_ref; }
+    bool send(JsonDocument &doc);
+
+    RealtimeSocket &_socket;
+    ArduinoJson::Allocator *_allocator;
+    Uplink *_uplink;
+    RealtimeChangeHandler _onChange;
+    const char *_accessToken, *_name, *_joinedAt;
+    char _topic[REALTIME_TOPIC_SIZE], _filter[REALTIME_FILTER_SIZE];
+
+    State _state;
+    bool _trackDue, _stale;
+    uint32_t _ref, _joinRef, _heartbeatRef, _broadcastRef, _broadcastSeq;
+    uint32_t _heartbeatAtMs, _rejoinAtMs;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "Schedule.h"
+
+DeviceSchedule::DeviceSchedule(uint32_t slotS) : _slotS(slotS), _sampledAtMs(0), _recorded(false), _joinedAt()
+{
+}
+
+void DeviceSchedule::begin(uint32_t nowMs)
+{
+    _sampledAtMs = nowMs;
+}
+
+bool DeviceSchedule::sampleDue(uint32_t nowMs)
+{
+    if (nowMs - _sampledAtMs <= SAMPLE_INTERVAL)
+        return false;
+    _sampledAtMs = nowMs;
+    return true;
+}
+
+uint32_t DeviceSchedule::untilSample(uint32_t nowMs) const
+{
+    uint32_t since = nowMs - _sampledAtMs;
+
+    return since <= SAMPLE_INTERVAL ? SAMPLE_INTERVAL + 1 - since : 0;
+}
+
+uint8_t DeviceSchedule::tick(unsigned long epoch, bool syncEnable)
+{
+    uint8_t due = 0;
+
+    if (epoch < MIN_VALID_EPOCH)
+    {
+        _recorded = false;
+        return 0;
+    }
+
+    if (!_joinedAt[0])
+    {
+        formatTimestamp(_joinedAt, sizeof(_joinedAt), epoch);
+        due |= SCHEDULE_JOINED;
+    }
+
+    // The first minute of the period in UTC, the same minute % 5 == 0 on the device's whole-hour local time
+    if ((epoch - _slotS) % UPLOAD_PERIOD < 60)
+    {
+        if (!_recorded && syncEnable)
+        {
+            _recorded = true;
+            due |= SCHEDULE_RECORD;
+        }
+    }
+    else
+        _recorded = false;
+
+    return due;
+}
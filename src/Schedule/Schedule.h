@@ -0,0 +1,59 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+// Plain C++ only: when the device samples, records and signs in, so the fleet simulator runs the
+// firmware's own schedule instead of a copy of it
+#include <PayloadCodec/PayloadCodec.h>
+
+#define SAMPLE_INTERVAL 1000U          // ms between sample ticks
+#define UPLOAD_PERIOD 300              // seconds between recorded measurements
+#define MIN_VALID_EPOCH 1577836800UL   // 2020-01-01, anything earlier means NTP never answered
+#define SIGN_IN_RETRY_MS 30000U        // after a failed sign-in or token refresh
+
+// What a sample tick asks the caller to do, as bits
+#define SCHEDULE_JOINED 0x01 // the clock became valid, joinedAt() is set: announce presence with it
+#define SCHEDULE_RECORD 0x02 // push a measurement stamped with this tick's epoch
+
+// The sample tick and the recording in the first minute of every UPLOAD_PERIOD, one recording per
+// period even though that minute holds sixty ticks
+class DeviceSchedule
+{
+public:
+    // slotS moves the recording that many seconds into the period, the firmware always records at 0
+    explicit DeviceSchedule(uint32_t slotS = 0);
+
+    // The first tick comes SAMPLE_INTERVAL after nowMs
+    void begin(uint32_t nowMs);
+    // True once more than SAMPLE_INTERVAL has passed since the last tick, which it then starts
+    bool sampleDue(uint32_t nowMs);
+    // ms to the next tick, for idling in between
+    uint32_t untilSample(uint32_t nowMs) const;
+
+    // Call on every tick with the UTC epoch, returns SCHEDULE_* bits. Nothing is recorded before the
+    // clock is valid or while syncEnable is off; turning it on inside the recording minute still records.
+    uint8_t tick(unsigned long epoch, bool syncEnable);
+
+    // UTC time the clock first became valid, empty before; stays at this address for presence
+    const char *joinedAt() const { return _joinedAt; }
+
+private:
+    uint32_t _slotS, _sampledAtMs;
+    bool _recorded;
+    char _joinedAt[TELEMETRY_TIMESTAMP_SIZE];
+};
+
+// When to sign in: right away at first, SIGN_IN_RETRY_MS after every failure
+class SignInRetry
+{
+public:
+    SignInRetry() : _retryAtMs(0) {}
+
+    void begin(uint32_t nowMs) { _retryAtMs = nowMs; }
+    bool due(uint32_t nowMs) const { return (int32_t)(nowMs - _retryAtMs) >= 0; }
+    void failed(uint32_t nowMs) { _retryAtMs = nowMs + SIGN_IN_RETRY_MS; }
+
+private:
+    uint32_t _retryAtMs;
+};
+
+#endif
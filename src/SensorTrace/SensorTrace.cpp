@@ -0,0 +1,83 @@
+#include "SensorTrace.h"
+#include <ReadFile/readfile.h>
+
+bool traceWriteHeader(Print &out)
+{
+    uint8_t header[TRACE_HEADER_SIZE];
+
+    traceEncodeHeader(header);
+    return out.write(header, sizeof(header)) == sizeof(header);
+}
+
+static RawSample history[TRACE_HISTORY_SIZE];
+static uint32_t historyEnd;
+
+bool traceWriteSample(Print &out, const RawSample &sample)
+{
+    uint8_t record[TRACE_RECORD_SIZE];
+
+    traceEncodeSample(record, sample);
+    return out.write(record, sizeof(record)) == sizeof(record);
+}
+
+void traceHistoryPush(const RawSample &sample)
+{
+    history[historyEnd % TRACE_HISTORY_SIZE] = sample;
+    historyEnd++;
+}
+
+void traceHistoryRange(uint32_t &first, uint32_t &end)
+{
+    end = historyEnd;
+    first = historyEnd > TRACE_HISTORY_SIZE ? historyEnd - TRACE_HISTORY_SIZE : 0;
+}
+
+bool traceHistoryGet(uint32_t seq, RawSample &sample)
+{
+    uint32_t first, end;
+
+    traceHistoryRange(first, end);
+    if (seq < first || seq >= end)
+        return false;
+
+    sample = history[seq % TRACE_HISTORY_SIZE];
+    return true;
+}
+
+bool traceAppend(const char *path, const RawSample &sample)
+{
+    File file = LittleFS.open(path, FILE_APPEND);
+    if (!file)
+        return false;
+
+    bool ok = file.size() < TRACE_MAX_SIZE;
+
+    if (ok && file.size() == 0)
+        ok = traceWriteHeader(file);
+    if (ok)
+        ok = traceWriteSample(file, sample);
+
+    file.close();
+    return ok;
+}
+
+bool FileTraceSource::open(const char *path)
+{
+    close();
+    // Opening a missing file for reading logs a VFS error, exists() doesn't
+    if (!LittleFS.exists(path))
+        return false;
+    _file = LittleFS.open(path, FILE_READ);
+    return (bool)_file;
+}
+
+void FileTraceSource::close()
+{
+    if (_file)
+        _file.close();
+}
+
+size_t FileTraceSource::read(uint8_t *buffer, size_t len)
+{
+    return _file ? _file.read(buffer, len) : 0;
+}
@@ -0,0 +1,37 @@
+#ifndef SENSORTRACE_H
+#define SENSORTRACE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <SensorTrace/TraceCodec.h>
+
+#define TRACE_MAX_SIZE (256 * 1024)
+#define TRACE_HISTORY_SIZE 256
+
+// Capture: the header is written once, then one fixed-size record per sample
+bool traceWriteHeader(Print &out);
+bool traceWriteSample(Print &out, const RawSample &sample);
+
+// Ring of the most recent samples kept in RAM, addressed by a running sequence number.
+// Sequences in [first, end) are available, older ones have been overwritten.
+void traceHistoryPush(const RawSample &sample);
+void traceHistoryRange(uint32_t &first, uint32_t &end);
+bool traceHistoryGet(uint32_t seq, RawSample &sample);
+
+// Starts or continues a capture file, returns false once it reaches TRACE_MAX_SIZE
+bool traceAppend(const char *path, const RawSample &sample);
+
+// A capture file on LittleFS as a replay source, open until close() or the next open()
+class FileTraceSource : public TraceSource
+{
+public:
+    bool open(const char *path);
+    void close();
+
+    size_t read(uint8_t *buffer, size_t len) override;
+
+private:
+    File _file;
+};
+
+#endif
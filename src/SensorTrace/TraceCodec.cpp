@@ -0,0 +1,106 @@
+#include "TraceCodec.h"
+#include <Crc32/Crc32.h>
+#include <string.h>
+
+void traceEncodeHeader(uint8_t *out)
+{
+    memset(out, 0, TRACE_HEADER_SIZE);
+    memcpy(out, TRACE_MAGIC, 4);
+    out[4] = TRACE_VERSION;
+    out[5] = TRACE_RECORD_SIZE;
+}
+
+bool traceCheckHeader(const uint8_t *header)
+{
+    return memcmp(header, TRACE_MAGIC, 4) == 0 && header[4] == TRACE_VERSION && header[5] == TRACE_RECORD_SIZE;
+}
+
+void traceEncodeSample(uint8_t *out, const RawSample &sample)
+{
+    // Field by field so the layout doesn't depend on struct padding, little endian like the ESP32
+    memcpy(out, &sample.timestamp, 4);
+    memcpy(out + 4, &sample.temperature, 4);
+    memcpy(out + 8, &sample.ph, 2);
+    memcpy(out + 10, &sample.turbidity, 2);
+    memcpy(out + 12, &sample.dissolvedOxygen, 2);
+}
+
+void traceDecodeSample(const uint8_t *in, RawSample &sample)
+{
+    memcpy(&sample.timestamp, in, 4);
+    memcpy(&sample.temperature, in + 4, 4);
+    memcpy(&sample.ph, in + 8, 2);
+    memcpy(&sample.turbidity, in + 10, 2);
+    memcpy(&sample.dissolvedOxygen, in + 12, 2);
+}
+
+size_t traceEncodeFrame(uint8_t *out, uint32_t firstSeq, const RawSample *samples, uint8_t count)
+{
+    size_t length = TRACE_FRAME_HEADER_SIZE + count * TRACE_RECORD_SIZE;
+    uint32_t crc;
+
+    out[0] = TRACE_FRAME_SYNC1;
+    out[1] = TRACE_FRAME_SYNC2;
+    memcpy(out + 2, &firstSeq, 4);
+    out[6] = count;
+    for (uint8_t i = 0; i < count; i++)
+        traceEncodeSample(out + TRACE_FRAME_HEADER_SIZE + i * TRACE_RECORD_SIZE, samples[i]);
+
+    crc = crc32Update(0, out + 2, length - 2);
+    memcpy(out + length, &crc, 4);
+    return length + 4;
+}
+
+size_t MemoryTraceSource::read(uint8_t *buffer, size_t len)
+{
+    size_t n = _size - _pos < len ? _size - _pos : len;
+
+    memcpy(buffer, _data + _pos, n);
+    _pos += n;
+    return n;
+}
+
+bool TraceReplay::begin(TraceSource &source)
+{
+    uint8_t header[TRACE_HEADER_SIZE];
+
+    _source = nullptr;
+    _samples = _firstMs = _lastMs = 0;
+    if (source.read(header, sizeof(header)) != sizeof(header) || !traceCheckHeader(header))
+        return false;
+
+    _source = &source;
+    return true;
+}
+
+bool TraceReplay::next(RawSample &sample)
+{
+    uint8_t record[TRACE_RECORD_SIZE];
+
+    if (!_source || _source->read(record, sizeof(record)) != sizeof(record))
+        return false;
+
+    traceDecodeSample(record, sample);
+    if (_samples++ == 0)
+        _firstMs = sample.timestamp;
+    _lastMs = sample.timestamp;
+    return true;
+}
+
+TraceReplayResult traceReplay(TraceSource &in, TraceSampleHandler handler)
+{
+    TraceReplayResult result = {0, 0, false};
+    TraceReplay replay;
+    RawSample sample;
+
+    if (!replay.begin(in))
+        return result;
+
+    while (replay.next(sample))
+        handler(sample);
+
+    result.samples = replay.samples();
+    result.tracedMs = replay.tracedMs();
+    result.ok = true;
+    return result;
+}
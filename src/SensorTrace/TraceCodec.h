@@ -0,0 +1,98 @@
+#ifndef TRACECODEC_H
+#define TRACECODEC_H
+
+// Plain C++ only: the trace record and export frame formats and the replay loop, so the host tests and
+// bench build them
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_MAGIC "AQTR"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 8
+#define TRACE_RECORD_SIZE 14
+
+// Export frame as `dump` streams it, all fields little endian:
+//   0xA5 0x5A | first seq (u32) | count (u8) | count trace records | CRC32 of seq..records (u32)
+// A frame with count 0 ends the export. tools/export/decode_export.py turns a capture into CSV.
+#define TRACE_FRAME_SYNC1 0xA5
+#define TRACE_FRAME_SYNC2 0x5A
+#define TRACE_FRAME_HEADER_SIZE 7
+#define TRACE_FRAME_SIZE(count) (TRACE_FRAME_HEADER_SIZE + (count) * TRACE_RECORD_SIZE + 4)
+
+// One unprocessed reading: ADC counts straight from the pins plus the DS18B20 probe value
+struct RawSample
+{
+    uint32_t timestamp; // millis() at capture
+    float temperature;
+    uint16_t ph;
+    uint16_t turbidity;
+    uint16_t dissolvedOxygen;
+};
+
+// Header of a capture: magic, version, record size, two reserved bytes
+void traceEncodeHeader(uint8_t *out);
+bool traceCheckHeader(const uint8_t *header);
+
+// One sample in its TRACE_RECORD_SIZE wire form and back
+void traceEncodeSample(uint8_t *out, const RawSample &sample);
+void traceDecodeSample(const uint8_t *in, RawSample &sample);
+
+// Frames count samples numbered from firstSeq into out, which holds TRACE_FRAME_SIZE(count) bytes.
+// Returns the frame length.
+size_t traceEncodeFrame(uint8_t *out, uint32_t firstSeq, const RawSample *samples, uint8_t count);
+
+// Where a replay reads a trace from: a file on the device, a buffer on the host
+class TraceSource
+{
+public:
+    virtual ~TraceSource() {}
+
+    // Up to len bytes, fewer only at the end of the trace
+    virtual size_t read(uint8_t *buffer, size_t len) = 0;
+};
+
+class MemoryTraceSource : public TraceSource
+{
+public:
+    MemoryTraceSource(const uint8_t *data, size_t size) : _data(data), _size(size), _pos(0) {}
+
+    size_t read(uint8_t *buffer, size_t len) override;
+
+private:
+    const uint8_t *_data;
+    size_t _size, _pos;
+};
+
+// Walks a trace a record at a time, so the firmware can spread a replay over its loop passes
+class TraceReplay
+{
+public:
+    TraceReplay() : _source(nullptr), _samples(0), _firstMs(0), _lastMs(0) {}
+
+    // Checks the header, false when source does not hold a trace
+    bool begin(TraceSource &source);
+    // The next record, false at the end of the trace; a partial record at the end is ignored
+    bool next(RawSample &sample);
+
+    uint32_t samples() const { return _samples; }
+    // Span of the recording read so far
+    uint32_t tracedMs() const { return _lastMs - _firstMs; }
+
+private:
+    TraceSource *_source;
+    uint32_t _samples, _firstMs, _lastMs;
+};
+
+typedef void (*TraceSampleHandler)(const RawSample &sample);
+
+struct TraceReplayResult
+{
+    uint32_t samples;
+    uint32_t tracedMs; // span of the recording itself
+    bool ok;
+};
+
+// Feeds every record of a trace to handler in one go
+TraceReplayResult traceReplay(TraceSource &in, TraceSampleHandler handler);
+
+#endif
@@ -0,0 +1,11 @@
+#include "Telemetry.h"
+
+void printUplinkStats(Print &out, const UplinkStats &stats, const Outbox &outbox)
+{
+    out.printf("uplink sent=%lu (primary=%lu fallback=%lu) rows=%lu failed=%lu timeouts=%lu pending=%u dropped=%lu "
+               "latency last=%lums max=%lums avg=%lums\n",
+               (unsigned long)stats.sent, (unsigned long)stats.primary, (unsigned long)stats.fallback,
+               (unsigned long)stats.rows, (unsigned long)stats.failed, (unsigned long)stats.timeouts,
+               (unsigned)outbox.pending(), (unsigned long)outbox.dropped(), (unsigned long)stats.lastLatencyMs,
+               (unsigned long)stats.maxLatencyMs, (unsigned long)(stats.sent ? stats.totalLatencyMs / stats.sent : 0));
+}
@@ -0,0 +1,14 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <ArenaAllocator/ArenaAllocator.h>
+#include <Outbox/Outbox.h>
+#include <PayloadCodec/PayloadCodec.h>
+#include <Uplink/Uplink.h>
+
+#define TELEMETRY_NAME_SIZE 64
+
+void printUplinkStats(Print &out, const UplinkStats &stats, const Outbox &outbox);
+
+#endif
@@ -0,0 +1,111 @@
+#include "Uplink.h"
+
+Uplink::Uplink(Outbox &outbox, const char *envId, uint32_t (*clockMs)())
+    : _outbox(outbox), _envId(envId), _clockMs(clockMs), _primary(nullptr), _fallback(nullptr), _inflight(nullptr),
+      _inflightSeq(0), _inflightRows(0), _startedMs(0), _retryAtMs(0), _backoff(0), _avoidPrimary(false), _stats()
+{
+}
+
+void Uplink::setTransports(UplinkTransport *primary, UplinkTransport *fallback)
+{
+    _primary = primary;
+    _fallback = fallback;
+}
+
+UplinkTransport *Uplink::pick()
+{
+    if (_primary && !_avoidPrimary && _outbox.pending() <= _primary->capacity() && _primary->ready())
+        return _primary;
+    if (_fallback && _fallback->ready())
+        return _fallback;
+    // Without a fallback the primary drains the backlog a delivery at a time
+    if (_primary && _primary->ready())
+        return _primary;
+    return nullptr;
+}
+
+void Uplink::poll()
+{
+    uint32_t now = _clockMs();
+    UplinkTransport *transport;
+    DeliveryResult result;
+    uint32_t first, lastSeq;
+
+    if (_inflight)
+    {
+        if (now - _startedMs < UPLINK_ACK_TIMEOUT_MS)
+            return;
+        _stats.timeouts++;
+        finish(false);
+    }
+
+    if (_outbox.pending() == 0)
+        return;
+    if (_backoff && (int32_t)(now - _retryAtMs) < 0)
+        return;
+
+    transport = pick();
+    if (!transport)
+        return;
+
+    first = _outbox.oldest();
+    lastSeq = first;
+    _stats.attempts++;
+    _startedMs = now;
+    result = transport->deliver(_outbox, _envId, lastSeq);
+
+    _inflight = transport;
+    _inflightSeq = lastSeq;
+    _inflightRows = lastSeq - first + 1;
+    if (result != DELIVERY_PENDING)
+        finish(result == DELIVERY_ACKED);
+}
+
+void Uplink::complete(const UplinkTransport *transport, uint32_t lastSeq, bool ok)
+{
+    if (!_inflight || transport != _inflight || lastSeq != _inflightSeq)
+        return;
+    finish(ok);
+}
+
+void Uplink::finish(bool ok)
+{
+    uint32_t now = _clockMs();
+    uint32_t latency = now - _startedMs;
+
+    if (ok)
+    {
+        _outbox.ack(_inflightSeq);
+        _stats.sent++;
+        _stats.rows += _inflightRows;
+        if (_inflight == _primary)
+            _stats.primary++;
+        else
+            _stats.fallback++;
+
+        _stats.lastLatencyMs = latency;
+        _stats.totalLatencyMs += latency;
+        if (latency > _stats.maxLatencyMs)
+            _stats.maxLatencyMs = latency;
+
+        _backoff = 0;
+        _avoidPrimary = false;
+    }
+    else
+    {
+        _stats.failed++;
+
+        // A failed broadcast is retried over the fallback straight away, anything else waits
+        if (_inflight == _primary && _fallback && !_avoidPrimary)
+            _avoidPrimary = true;
+        else
+        {
+            _backoff = _backoff ? _backoff * 2 : UPLINK_RETRY_MIN_MS;
+            if (_backoff > UPLINK_RETRY_MAX_MS)
+                _backoff = UPLINK_RETRY_MAX_MS;
+            _retryAtMs = now + _backoff;
+        }
+    }
+
+    _inflight = nullptr;
+}
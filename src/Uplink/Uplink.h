@@ -0,0 +1,88 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+// Plain C++ only, the host soak and fleet harnesses drive the same scheduler as the firmware
+#include <Outbox/Outbox.h>
+
+#define UPLINK_ACK_TIMEOUT_MS 10000U // an unanswered delivery counts as failed after this
+#define UPLINK_RETRY_MIN_MS 5000U
+#define UPLINK_RETRY_MAX_MS 300000U
+
+enum DeliveryResult
+{
+    DELIVERY_FAILED,
+    DELIVERY_PENDING, // sent, Uplink::complete() reports the outcome later
+    DELIVERY_ACKED,
+};
+
+// Which transport carries the newest row. Supabase acknowledges realtime broadcasts without storing
+// them, so TRANSPORT_REALTIME only delivers where something subscribed to the channel writes them to
+// measurements; TRANSPORT_HTTP sends every row through the HTTP batch.
+enum TelemetryTransport
+{
+    TRANSPORT_HTTP,
+    TRANSPORT_REALTIME,
+};
+
+// One way of getting rows to the server
+class UplinkTransport
+{
+public:
+    virtual ~UplinkTransport() {}
+
+    virtual bool ready() = 0;
+    // Rows a single delivery carries at most
+    virtual size_t capacity() const = 0;
+    // Sends the oldest pending rows, lastSeq receives the outbox sequence of the last one included
+    virtual DeliveryResult deliver(const Outbox &outbox, const char *envId, uint32_t &lastSeq) = 0;
+};
+
+struct UplinkStats
+{
+    uint32_t attempts;
+    uint32_t sent;     // deliveries acknowledged
+    uint32_t failed;   // refused, failed or timed out
+    uint32_t timeouts; // no answer within UPLINK_ACK_TIMEOUT_MS
+    uint32_t rows;     // rows acknowledged
+    uint32_t primary;  // acknowledged deliveries per transport
+    uint32_t fallback;
+    uint32_t lastLatencyMs;
+    uint32_t maxLatencyMs;
+    uint32_t totalLatencyMs; // over acknowledged deliveries
+};
+
+// Drains an outbox with one delivery in flight at a time.
+// The primary transport carries the newest row when it is the only one pending, the fallback
+// backfills anything older; with no fallback the primary carries everything. Failures back off
+// exponentially.
+class Uplink
+{
+public:
+    Uplink(Outbox &outbox, const char *envId, uint32_t (*clockMs)());
+
+    void setTransports(UplinkTransport *primary, UplinkTransport *fallback);
+
+    // Call from the main loop: expires an unanswered delivery and starts the next one when due
+    void poll();
+    // Outcome of a DELIVERY_PENDING delivery, answers for anything but the one in flight are ignored
+    void complete(const UplinkTransport *transport, uint32_t lastSeq, bool ok);
+
+    bool busy() const { return _inflight != nullptr; }
+    uint32_t backoffMs() const { return _backoff; }
+    const UplinkStats &stats() const { return _stats; }
+
+private:
+    UplinkTransport *pick();
+    void finish(bool ok);
+
+    Outbox &_outbox;
+    const char *_envId;
+    uint32_t (*_clockMs)();
+    UplinkTransport *_primary, *_fallback, *_inflight;
+    uint32_t _inflightSeq, _inflightRows, _startedMs;
+    uint32_t _retryAtMs, _backoff; // no delivery before _retryAtMs while _backoff is non-zero
+    bool _avoidPrimary;            // the primary failed, use the fallback until something gets through
+    UplinkStats _stats;
+};
+
+#endif
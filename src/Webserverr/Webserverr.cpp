@@ -22,7 +22,7 @@ void handleGetWifiConfig(AsyncWebServerRequest *request)
 
         if (error)
         {
-            SPIFFS.remove("/wifi.json");
+            LittleFS.remove("/wifi.json");
             request->send(400, "application/json", "{\"message\":\"Failed to read WiFi configuration.\"}");
             return;
         }
@@ -50,16 +50,12 @@ void handleSaveWifiConfig(AsyncWebServerRequest *request, uint8_t *data, size_t
         return;
     }
 
-    File file = SPIFFS.open("/wifi.json", FILE_WRITE);
-    if (!file)
+    if (!writeJsonFile("/wifi.json", jsonObj))
     {
         request->send(500, "application/json", "{\"message\":\"Failed to save WiFi configuration.\"}");
         return;
     }
 
-    serializeJson(jsonObj, file);
-    file.close();
-
     request->send(200, "application/json", "{\"message\":\"WiFi configuration has been saved.\"}");
     jsonObj.clear();
     json.clear();
@@ -151,7 +147,7 @@ void handleWifiStatus(AsyncWebServerRequest *request)
 
         if (error)
         {
-            SPIFFS.remove("/wifi.json");
+            LittleFS.remove("/wifi.json");
 
             resJson["data"].clear();
             serializeJson(resJson, res);
@@ -195,7 +191,7 @@ void handleConnect(AsyncWebServerRequest *request)
 
     if (error)
     {
-        SPIFFS.remove("/wifi.json");
+        LittleFS.remove("/wifi.json");
         request->send(400, "application/json", "{\"message\":\"Failed to read WiFi configuration.\"}");
         return;
     }
@@ -220,16 +216,12 @@ void handleSaveUserConfig(AsyncWebServerRequest *request, uint8_t *data, size_t
         return;
     }
 
-    File file = SPIFFS.open("/user.json", FILE_WRITE);
-    if (!file)
+    if (!writeJsonFile("/user.json", jsonObj))
     {
         request->send(500, "application/json", "{\"message\":\"Failed to save user configuration.\"}");
         return;
     }
 
-    serializeJson(jsonObj, file);
-    file.close();
-
     request->send(200, "application/json", "{\"message\":\"User configuration has been saved.\"}");
     jsonObj.clear();
     json.clear();
@@ -258,7 +250,7 @@ void handleGetUserConfig(AsyncWebServerRequest *request)
 
     if (error)
     {
-        SPIFFS.remove("/user.json");
+        LittleFS.remove("/user.json");
         request->send(400, "application/json", "{\"message\":\"Failed to read user configuration.\"}");
         return;
     }
@@ -290,8 +282,7 @@ void handleSaveEnvironment(AsyncWebServerRequest *request, uint8_t *data, size_t
         return;
     }
 
-    File file = SPIFFS.open("/environment.json", FILE_WRITE);
-    if (!file)
+    if (!writeJsonFile("/environment.json", jsonObj))
     {
         request->send(500, "application/json", "{\"message\":\"Failed to save environment.\"}");
         json.clear();
@@ -299,9 +290,6 @@ void handleSaveEnvironment(AsyncWebServerRequest *request, uint8_t *data, size_t
         return;
     }
 
-    serializeJson(jsonObj, file);
-    file.close();
-
     request->send(200, "application/json", "{\"message\":\"Environment has been saved.\"}");
     jsonObj.clear();
     json.clear();
@@ -330,7 +318,7 @@ void handleGetEnvironment(AsyncWebServerRequest *request)
 
     if (error)
     {
-        SPIFFS.remove("/environment.json");
+        LittleFS.remove("/environment.json");
         request->send(400, "application/json", "{\"message\":\"Failed to read environment.\"}");
         return;
     }
@@ -365,12 +353,12 @@ void setupWebserver(AsyncWebServer &server)
     server.on("/api/environment", HTTP_POST, [](AsyncWebServerRequest *request)
               { request->send(400, "application/json", "{\"message\":\"Body is required.\"}"); }, nullptr, handleSaveEnvironment);
 
-    // Serve static files from SPIFFS
-    server.serveStatic("/", SPIFFS, "/").setDefaultFile("index.html");
+    // Serve static files from LittleFS
+    server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
 
     // Catch-all route to handle React's single-page app routing
     server.onNotFound([](AsyncWebServerRequest *request)
-                      { request->send(SPIFFS, "/index.html", String(), false); });
+                      { request->send(LittleFS, "/index.html", String(), false); });
 
     DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
 
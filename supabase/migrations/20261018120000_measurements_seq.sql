@@ -0,0 +1,13 @@
+-- Per-device sequence numbers on measurements, for firmware that upserts with
+-- ?on_conflict=env_id,seq (TELEMETRY_UPSERT_QUERY in src/main.cpp).
+--
+-- seq is boot count << 32 | outbox sequence, unique per env_id, so a batch re-sent after its
+-- acknowledgement was lost is ignored instead of stored twice. PostgREST rejects rows with a column
+-- the table lacks and an on_conflict target without a matching unique index, so apply this before
+-- flashing that firmware: `supabase db push` on a linked project (a local `supabase start` applies
+-- supabase/migrations by itself), or run it in the SQL editor.
+
+alter table public.measurements add column if not exists seq bigint;
+
+-- Rows from earlier firmware keep a NULL seq, NULLs never collide in a unique index
+create unique index if not exists measurements_env_id_seq_key on public.measurements (env_id, seq);
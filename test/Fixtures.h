@@ -0,0 +1,15 @@
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+// Shared by the host tests: the env_id rows go out under and a plain reading to queue
+#include <PayloadCodec/PayloadCodec.h>
+
+#define UUID "3f2b8c1e-9a4d-4e7b-8c21-5d6e7f809a1b"
+
+inline Measurement row(unsigned long epoch)
+{
+    Measurement m = {25.0f, 7.0f, 10.0f, 6.5f, epoch, 0};
+    return m;
+}
+
+#endif
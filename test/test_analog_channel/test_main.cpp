@@ -0,0 +1,100 @@
+#include <AnalogChannel/AnalogChannel.h>
+#include <DissolvedOxygen/DissolvedOxygen.h>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+constexpr CurvePoint turbidityCurve[] = {{0, 0}, {2080, 100}};
+constexpr CurvePoint bentCurve[] = {{0, 0}, {1000, 10}, {2000, 110}};
+
+typedef AnalogChannel<32, PiecewiseLinear(turbidityCurve), Percent> TurbidityChannel;
+typedef AnalogChannel<35, DissolvedOxygenCurve, MilligramsPerLitre> DissolvedOxygenChannel;
+typedef AnalogChannel<33, PiecewiseLinear(bentCurve), Millivolts, MovingAverage<4>> AveragedChannel;
+
+void test_millivolts_span_the_adc()
+{
+    TEST_ASSERT_EQUAL_FLOAT(0, TurbidityChannel::millivolts(0));
+    TEST_ASSERT_EQUAL_FLOAT(3300, TurbidityChannel::millivolts(4095));
+}
+
+void test_piecewise_curve_interpolates_and_extrapolates()
+{
+    typedef PiecewiseLinear(bentCurve) Curve;
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 5, Curve::apply(500, 0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 10, Curve::apply(1000, 0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 60, Curve::apply(1500, 0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -1, Curve::apply(-100, 0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 210, Curve::apply(3000, 0));
+}
+
+void test_turbidity_keeps_the_fraction()
+{
+    // 1040 mV is half way, the old integer map() truncated readings to whole percent
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, PiecewiseLinear(turbidityCurve)::apply(1040, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.5f, PiecewiseLinear(turbidityCurve)::apply(1050.4f, 0));
+}
+
+void test_moving_average_filters_before_conversion()
+{
+    AveragedChannel::filter(0);
+    AveragedChannel::filter(0);
+    // Mean of 0, 0, 3300 mV is 1100 mV, on the steep segment
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20, AveragedChannel::convert(AveragedChannel::filter(4095), 0));
+    // Mean of 0, 0, 3300, 0 mV is 825 mV, on the shallow one
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 8.25f, AveragedChannel::convert(AveragedChannel::filter(0), 0));
+}
+
+void test_convert_leaves_the_filter_alone()
+{
+    typedef AnalogChannel<36, PiecewiseLinear(bentCurve), Millivolts, MovingAverage<2>> Channel;
+
+    Channel::filter(0);
+    // History and replay conversions in between must not reach the live window
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 110, Channel::convert(2000.0f, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 110, Channel::convert(2000.0f, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1650, Channel::filter(4095));
+}
+
+void test_dissolved_oxygen_at_calibration_point()
+{
+    // At the 22 ℃ calibration the saturation voltage is 550 mV and the table gives 8.73 mg/L
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 8.73f, DissolvedOxygenCurve::apply(550, 22));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.365f, DissolvedOxygenCurve::apply(275, 22));
+}
+
+void test_dissolved_oxygen_without_temperature_is_nan()
+{
+    TEST_ASSERT_FLOAT_IS_NAN(DissolvedOxygenCurve::apply(550, DEVICE_DISCONNECTED_C));
+    TEST_ASSERT_FLOAT_IS_NAN(DissolvedOxygenCurve::apply(550, NAN));
+    TEST_ASSERT_FLOAT_IS_NAN(
+        DissolvedOxygenChannel::convert(DissolvedOxygenChannel::millivolts(2000), DEVICE_DISCONNECTED_C));
+}
+
+void test_dissolved_oxygen_in_cold_water_is_nan()
+{
+    TEST_ASSERT_FLOAT_IS_NAN(DissolvedOxygenCurve::apply(550, 6));
+    TEST_ASSERT_FLOAT_IS_NAN(DissolvedOxygenCurve::apply(550, -3));
+    TEST_ASSERT_TRUE(DissolvedOxygenCurve::apply(550, 7) > 0);
+}
+
+void test_dissolved_oxygen_clamps_hot_water_to_table()
+{
+    TEST_ASSERT_EQUAL_FLOAT(DissolvedOxygenCurve::apply(550, 40), DissolvedOxygenCurve::apply(550, 55));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_millivolts_span_the_adc);
+    RUN_TEST(test_piecewise_curve_interpolates_and_extrapolates);
+    RUN_TEST(test_turbidity_keeps_the_fraction);
+    RUN_TEST(test_moving_average_filters_before_conversion);
+    RUN_TEST(test_convert_leaves_the_filter_alone);
+    RUN_TEST(test_dissolved_oxygen_at_calibration_point);
+    RUN_TEST(test_dissolved_oxygen_without_temperature_is_nan);
+    RUN_TEST(test_dissolved_oxygen_in_cold_water_is_nan);
+    RUN_TEST(test_dissolved_oxygen_clamps_hot_water_to_table);
+    return UNITY_END();
+}
@@ -0,0 +1,314 @@
+#include <ArenaAllocator/ArenaAllocator.h>
+#include <Fixtures.h>
+#include <Outbox/Outbox.h>
+#include <PayloadCodec/PayloadCodec.h>
+#include <Realtime/RealtimeChannel.h>
+#include <Uplink/Uplink.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <unity.h>
+
+#define ITERATIONS 1000
+
+// Counts every heap allocation made while `counting` is set. glibc lets the test replace
+// malloc and friends and forward to the real ones, elsewhere only operator new is seen.
+static size_t allocations;
+static bool counting;
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void __libc_free(void *);
+
+extern "C" void *malloc(size_t size)
+{
+    if (counting)
+        allocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if (counting)
+        allocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    if (counting)
+        allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+#else
+void *operator new(size_t size)
+{
+    if (counting)
+        allocations++;
+    void *ptr = malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+#endif
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+// What the realtime channel hands to HandleChanges for an UPDATE of the aquarium row
+static const char updateMessage[] =
+    "{\"schema\":\"public\",\"table\":\"aquarium\",\"commit_timestamp\":\"2024-12-10T15:19:42.123Z\","
+    "\"type\":\"UPDATE\",\"columns\":[{\"name\":\"id\",\"type\":\"uuid\"},{\"name\":\"name\",\"type\":\"text\"},"
+    "{\"name\":\"min_ph\",\"type\":\"float8\"},{\"name\":\"max_ph\",\"type\":\"float8\"}],"
+    "\"record\":{\"id\":\"" UUID "\",\"name\":\"Living room tank\",\"min_ph\":6.5,\"max_ph\":7.8,"
+    "\"min_temperature\":24,\"max_temperature\":28,\"min_do\":5,\"max_do\":9,\"min_turbidity\":0,"
+    "\"max_turbidity\":40,\"user_id\":\"9a0c5e7d-2f61-4b3a-8d9e-1c2b3a4d5e6f\"},"
+    "\"old_record\":{\"id\":\"" UUID "\"},\"errors\":null}";
+
+static uint8_t arenaBuffer[4096];
+static uint8_t aquariumBuffer[2048];
+
+void setUp()
+{
+    allocations = 0;
+    counting = false;
+}
+
+void tearDown()
+{
+    counting = false;
+}
+
+void test_counter_sees_heap_allocations()
+{
+    counting = true;
+    char *p = new char[16];
+    counting = false;
+    delete[] p;
+
+    TEST_ASSERT_GREATER_THAN(0, allocations);
+}
+
+void test_arena_rewinds_when_empty()
+{
+    ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+    void *a = arena.allocate(10);
+    void *b = arena.allocate(100);
+
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)a % 8);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)b % 8);
+    arena.deallocate(a);
+    TEST_ASSERT_NOT_EQUAL(0, arena.used());
+    arena.deallocate(b);
+    TEST_ASSERT_EQUAL(0, arena.used());
+    TEST_ASSERT_GREATER_OR_EQUAL(128, arena.peak());
+}
+
+void test_arena_grows_tail_in_place()
+{
+    ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+    void *a = arena.allocate(16);
+
+    memset(a, 0x5A, 16);
+    TEST_ASSERT_EQUAL_PTR(a, arena.reallocate(a, 512));
+    TEST_ASSERT_EQUAL_UINT8(0x5A, ((uint8_t *)a)[15]);
+    TEST_ASSERT_EQUAL_PTR(a, arena.reallocate(a, 32));
+    TEST_ASSERT_LESS_THAN(64, arena.used());
+}
+
+void test_arena_moves_inner_block()
+{
+    ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+    void *a = arena.allocate(16);
+    void *b = arena.allocate(16);
+    void *moved;
+
+    memcpy(a, "0123456789abcdef", 16);
+    moved = arena.reallocate(a, 64);
+    TEST_ASSERT_NOT_NULL(moved);
+    TEST_ASSERT_NOT_EQUAL(a, moved);
+    TEST_ASSERT_EQUAL_MEMORY("0123456789abcdef", moved, 16);
+
+    arena.deallocate(b);
+    arena.deallocate(moved);
+    TEST_ASSERT_EQUAL(0, arena.used());
+}
+
+void test_arena_reports_exhaustion()
+{
+    ArenaAllocator arena(arenaBuffer, 64);
+
+    TEST_ASSERT_NULL(arena.allocate(100));
+    TEST_ASSERT_EQUAL(1, arena.failures());
+}
+
+void test_realtime_update_parses_into_arena()
+{
+    ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+    {
+        JsonDocument doc(&arena);
+
+        TEST_ASSERT_FALSE(deserializeJson(doc, updateMessage, strlen(updateMessage)));
+        TEST_ASSERT_EQUAL_STRING(UUID, doc["record"]["id"].as<const char *>());
+        TEST_ASSERT_EQUAL_FLOAT(7.8f, doc["record"]["max_ph"].as<float>());
+    }
+    TEST_ASSERT_EQUAL(0, arena.used());
+    TEST_ASSERT_EQUAL(0, arena.failures());
+}
+
+void test_oversized_update_fails_cleanly()
+{
+    ArenaAllocator arena(arenaBuffer, 256);
+    JsonDocument doc(&arena);
+
+    TEST_ASSERT_EQUAL(DeserializationError::NoMemory, deserializeJson(doc, updateMessage, strlen(updateMessage)).code());
+    TEST_ASSERT_GREATER_THAN(0, arena.failures());
+}
+
+// Keeps the ref of the last message the channel sent, scanned from the text so the test itself
+// stays off the heap
+class RefSocket : public RealtimeSocket
+{
+public:
+    RefSocket() : ref(0), sent(0) {}
+
+    bool sendText(const char *text, size_t len) override
+    {
+        const char *at;
+
+        if (len >= sizeof(last))
+            return false;
+        memcpy(last, text, len);
+        last[len] = '\0';
+        if ((at = strstr(last, "\"ref\":\"")) == nullptr)
+            return false;
+        ref = strtoul(at + 7, nullptr, 10);
+        sent++;
+        return true;
+    }
+
+    char last[REALTIME_MESSAGE_SIZE];
+    unsigned long ref;
+    uint32_t sent;
+};
+
+static uint32_t now;
+
+static uint32_t clockMs()
+{
+    return now;
+}
+
+static void replyOk(RealtimeChannel &channel, unsigned long ref)
+{
+    char text[160];
+    int n = snprintf(text, sizeof(text),
+                     "{\"topic\":\"realtime:aquarium:" UUID "\",\"event\":\"phx_reply\","
+                     "\"payload\":{\"status\":\"ok\",\"response\":{}},\"ref\":\"%lu\"}",
+                     ref);
+    channel.received(text, n, now);
+}
+
+// The steady-state tick (encode a row, batch the outbox, broadcast it over the realtime channel,
+// apply a realtime update) must not touch the heap once the first pass has warmed everything up
+void test_steady_state_does_not_allocate()
+{
+    static uint8_t batch[OUTBOX_BATCH_SIZE];
+    ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+    ArenaAllocator aquariumArena(aquariumBuffer, sizeof(aquariumBuffer));
+    JsonDocument aquarium(&aquariumArena);
+    Outbox outbox, broadcasts;
+    char row[TELEMETRY_PAYLOAD_SIZE];
+    uint32_t lastSeq;
+    RefSocket socket;
+    RealtimeChannel channel(socket, &arena);
+    Uplink uplink(broadcasts, UUID, clockMs);
+
+    now = 1000;
+    channel.begin(UUID, "token", nullptr);
+    channel.setPresence("Reef", "2024-12-10T15:15:00Z");
+    channel.setUplink(&uplink);
+    uplink.setTransports(&channel, nullptr);
+    channel.connected(now);
+    replyOk(channel, socket.ref);
+    TEST_ASSERT_TRUE(channel.joined());
+
+    for (int i = 0; i <= ITERATIONS; i++)
+    {
+        if (i == 1)
+            counting = true;
+
+        Measurement m = {25.0f + i % 10, 7.0f, 12.5f, 6.5f, 1733843700UL + i * 300UL, 0};
+        TEST_ASSERT_NOT_EQUAL(0, buildPayload(row, sizeof(row), UUID, m));
+
+        // The presence track and the heartbeats that come due get answered, like the server does
+        uint32_t sent = socket.sent;
+        now += 1000;
+        channel.poll(now);
+        if (socket.sent != sent)
+            replyOk(channel, socket.ref);
+
+        // Every row goes out as a broadcast and is acked
+        broadcasts.push(m);
+        uplink.poll();
+        TEST_ASSERT_EQUAL(1, broadcasts.pending());
+        replyOk(channel, socket.ref);
+        TEST_ASSERT_EQUAL(0, broadcasts.pending());
+
+        outbox.push(m);
+        TEST_ASSERT_NOT_EQUAL(0, outbox.encode(ENCODING_JSON, batch, sizeof(batch), UUID, lastSeq));
+        TEST_ASSERT_NOT_EQUAL(0, outbox.encode(ENCODING_CBOR, batch, sizeof(batch), UUID, lastSeq));
+        if (i % 3 == 0)
+            outbox.ack(lastSeq);
+
+        JsonDocument doc(&arena);
+        TEST_ASSERT_FALSE(deserializeJson(doc, updateMessage, strlen(updateMessage)));
+        TEST_ASSERT_TRUE(aquarium.set(doc["record"]));
+    }
+    counting = false;
+
+    TEST_ASSERT_EQUAL(0, allocations);
+    TEST_ASSERT_EQUAL(0, arena.failures());
+    TEST_ASSERT_EQUAL(0, aquariumArena.failures());
+    TEST_ASSERT_EQUAL(ITERATIONS + 1, uplink.stats().sent);
+    TEST_ASSERT_TRUE(channel.healthy());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_counter_sees_heap_allocations);
+    RUN_TEST(test_arena_rewinds_when_empty);
+    RUN_TEST(test_arena_grows_tail_in_place);
+    RUN_TEST(test_arena_moves_inner_block);
+    RUN_TEST(test_arena_reports_exhaustion);
+    RUN_TEST(test_realtime_update_parses_into_arena);
+    RUN_TEST(test_oversized_update_fails_cleanly);
+    RUN_TEST(test_steady_state_does_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <Crc32/Crc32.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t crcOf(const char *text)
+{
+    return crc32Update(0, (const uint8_t *)text, strlen(text));
+}
+
+void test_check_value()
+{
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crcOf("123456789"));
+}
+
+void test_empty_input()
+{
+    TEST_ASSERT_EQUAL_HEX32(0, crcOf(""));
+}
+
+void test_incremental_matches_one_shot()
+{
+    const char *text = "{\"ssid\":\"aquarium\",\"password\":\"secret\"}";
+    size_t len = strlen(text);
+
+    for (size_t split = 0; split <= len; split++)
+    {
+        uint32_t crc = crc32Update(0, (const uint8_t *)text, split);
+        crc = crc32Update(crc, (const uint8_t *)text + split, len - split);
+        TEST_ASSERT_EQUAL_HEX32(crcOf(text), crc);
+    }
+}
+
+void test_detects_single_bit_flip()
+{
+    uint8_t data[14] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+    uint32_t clean = crc32Update(0, data, sizeof(data));
+
+    for (size_t bit = 0; bit < sizeof(data) * 8; bit++)
+    {
+        data[bit / 8] ^= 1 << (bit % 8);
+        TEST_ASSERT_NOT_EQUAL(clean, crc32Update(0, data, sizeof(data)));
+        data[bit / 8] ^= 1 << (bit % 8);
+    }
+}
+
+static Crc32Trailer check(const char *text, size_t &bodyLen)
+{
+    return crc32CheckTrailer((const uint8_t *)text, strlen(text), bodyLen);
+}
+
+void test_trailer_round_trip()
+{
+    char file[64], trailer[CRC32_TRAILER_SIZE + 1];
+    size_t bodyLen;
+
+    crc32FormatTrailer(trailer, crcOf("{\"ssid\":\"tank\"}"));
+    TEST_ASSERT_EQUAL(CRC32_TRAILER_SIZE, strlen(trailer));
+    snprintf(file, sizeof(file), "{\"ssid\":\"tank\"}%s", trailer);
+
+    TEST_ASSERT_EQUAL(CRC32_TRAILER_OK, check(file, bodyLen));
+    TEST_ASSERT_EQUAL(strlen("{\"ssid\":\"tank\"}"), bodyLen);
+}
+
+void test_trailer_detects_corruption()
+{
+    char file[64], trailer[CRC32_TRAILER_SIZE + 1];
+    size_t bodyLen;
+
+    crc32FormatTrailer(trailer, crcOf("{\"ssid\":\"tank\"}"));
+    snprintf(file, sizeof(file), "{\"ssid\":\"tonk\"}%s", trailer);
+
+    TEST_ASSERT_EQUAL(CRC32_TRAILER_MISMATCH, check(file, bodyLen));
+}
+
+void test_file_without_trailer_is_legacy()
+{
+    size_t bodyLen;
+
+    TEST_ASSERT_EQUAL(CRC32_TRAILER_MISSING, check("{\"ssid\":\"tank\"}", bodyLen));
+    TEST_ASSERT_EQUAL(strlen("{\"ssid\":\"tank\"}"), bodyLen);
+    TEST_ASSERT_EQUAL(CRC32_TRAILER_MISSING, check("", bodyLen));
+    TEST_ASSERT_EQUAL(CRC32_TRAILER_MISSING, check("{}\n#crc32:0000zzzz", bodyLen));
+}
+
+void test_truncated_file_is_not_ok()
+{
+    char file[64], trailer[CRC32_TRAILER_SIZE + 1];
+    size_t bodyLen;
+
+    crc32FormatTrailer(trailer, crcOf("{\"ssid\":\"tank\"}"));
+    snprintf(file, sizeof(file), "{\"ssid\":\"tank\"}%s", trailer);
+
+    for (size_t len = 0; len < strlen(file); len++)
+        TEST_ASSERT_NOT_EQUAL(CRC32_TRAILER_OK, crc32CheckTrailer((const uint8_t *)file, len, bodyLen));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_check_value);
+    RUN_TEST(test_empty_input);
+    RUN_TEST(test_incremental_matches_one_shot);
+    RUN_TEST(test_detects_single_bit_flip);
+    RUN_TEST(test_trailer_round_trip);
+    RUN_TEST(test_trailer_detects_corruption);
+    RUN_TEST(test_file_without_trailer_is_legacy);
+    RUN_TEST(test_truncated_file_is_not_ok);
+    return UNITY_END();
+}
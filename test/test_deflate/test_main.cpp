@@ -0,0 +1,98 @@
+#include <Deflate/Deflate.h>
+#include <Fixtures.h>
+#include <Outbox/Outbox.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include <zlib.h>
+
+static DeflateWorkspace work;
+static uint8_t input[8192], compressed[10000], restored[8192];
+
+void setUp() {}
+void tearDown() {}
+
+// Inflates with zlib, the way the ingest side does, and checks the round trip
+static void assertRoundTrip(const uint8_t *in, size_t len)
+{
+    size_t n = deflateCompress(work, in, len, compressed, sizeof(compressed));
+    uLongf restoredLen = sizeof(restored);
+
+    TEST_ASSERT_NOT_EQUAL(0, n);
+    TEST_ASSERT_EQUAL(Z_OK, uncompress(restored, &restoredLen, compressed, n));
+    TEST_ASSERT_EQUAL(len, restoredLen);
+    TEST_ASSERT_EQUAL_MEMORY(in, restored, len);
+}
+
+void test_adler32_reference()
+{
+    TEST_ASSERT_EQUAL_HEX32(0x11E60398, adler32((const uint8_t *)"Wikipedia", 9));
+    TEST_ASSERT_EQUAL_HEX32(1, adler32(nullptr, 0));
+}
+
+void test_empty_input()
+{
+    assertRoundTrip(input, 0);
+}
+
+void test_text_round_trip()
+{
+    const char *text = "{\"temp\":25.125,\"temp\":25.125,\"temp\":25.250}";
+
+    assertRoundTrip((const uint8_t *)text, strlen(text));
+}
+
+void test_random_bytes_round_trip()
+{
+    srand(7);
+    for (size_t i = 0; i < sizeof(input); i++)
+        input[i] = rand();
+    assertRoundTrip(input, sizeof(input));
+}
+
+void test_long_runs_round_trip()
+{
+    // Runs longer than the 258 byte match limit and matches reaching back the whole window
+    memset(input, 'a', 3000);
+    for (size_t i = 3000; i < sizeof(input); i++)
+        input[i] = "0123456789"[(i / 1000) % 10];
+    assertRoundTrip(input, sizeof(input));
+}
+
+void test_output_too_small()
+{
+    memset(input, 'x', 100);
+    TEST_ASSERT_EQUAL(0, deflateCompress(work, input, 100, compressed, 8));
+}
+
+void test_outbox_batch_shrinks()
+{
+    static uint8_t batch[OUTBOX_BATCH_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+    size_t len, n;
+
+    for (unsigned long i = 0; i < OUTBOX_SIZE; i++)
+    {
+        Measurement m = {25.0f + (i % 3) * 0.125f, 7.1f + (i % 2) * 0.01f, 12.0f, 6.5f, 1733843700UL + i * 300, 0};
+        outbox.push(m);
+    }
+
+    len = outbox.encode(ENCODING_JSON, batch, sizeof(batch), UUID, lastSeq);
+    n = deflateCompress(work, batch, len, compressed, sizeof(compressed));
+    assertRoundTrip(batch, len);
+    TEST_ASSERT_LESS_THAN(len / 4, n);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_adler32_reference);
+    RUN_TEST(test_empty_input);
+    RUN_TEST(test_text_round_trip);
+    RUN_TEST(test_random_bytes_round_trip);
+    RUN_TEST(test_long_runs_round_trip);
+    RUN_TEST(test_output_too_small);
+    RUN_TEST(test_outbox_batch_shrinks);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+#include <Fixtures.h>
+#include <Outbox/Outbox.h>
+#include <string.h>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+static size_t countRows(const char *json)
+{
+    size_t n = 0;
+
+    for (const char *p = json; (p = strstr(p, "\"env_id\"")) != nullptr; p++)
+        n++;
+    return n;
+}
+
+void test_push_assigns_sequences()
+{
+    Outbox outbox;
+
+    TEST_ASSERT_EQUAL(0, outbox.push(row(0)));
+    TEST_ASSERT_EQUAL(1, outbox.push(row(300)));
+    TEST_ASSERT_EQUAL(2, outbox.pending());
+}
+
+void test_encode_then_ack_retires_rows()
+{
+    static uint8_t out[OUTBOX_BATCH_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+
+    outbox.push(row(0));
+    outbox.push(row(300));
+    TEST_ASSERT_NOT_EQUAL(0, outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq));
+    TEST_ASSERT_EQUAL(1, lastSeq);
+    TEST_ASSERT_EQUAL('[', out[0]);
+    TEST_ASSERT_EQUAL(2, countRows((const char *)out));
+
+    outbox.ack(lastSeq);
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+    TEST_ASSERT_EQUAL(0, outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq));
+}
+
+void test_failed_upload_keeps_rows()
+{
+    static uint8_t out[OUTBOX_BATCH_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+
+    outbox.push(row(0));
+    outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq);
+    outbox.push(row(300));
+    outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq);
+    TEST_ASSERT_EQUAL(2, countRows((const char *)out));
+}
+
+void test_full_outbox_drops_oldest()
+{
+    static uint8_t out[OUTBOX_BATCH_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+
+    for (unsigned long i = 0; i < OUTBOX_SIZE + 3; i++)
+        outbox.push(row(i * 300));
+
+    TEST_ASSERT_EQUAL(OUTBOX_SIZE, outbox.pending());
+    TEST_ASSERT_EQUAL(3, outbox.dropped());
+    TEST_ASSERT_NOT_EQUAL(0, outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq));
+    TEST_ASSERT_EQUAL(OUTBOX_SIZE + 2, lastSeq);
+    TEST_ASSERT_EQUAL(OUTBOX_SIZE, countRows((const char *)out));
+}
+
+void test_ack_after_drop_during_flight()
+{
+    static uint8_t out[OUTBOX_BATCH_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+
+    for (unsigned long i = 0; i < OUTBOX_SIZE; i++)
+        outbox.push(row(i * 300));
+    outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq);
+
+    // One more row lands while the batch is in flight and pushes the oldest out
+    outbox.push(row(OUTBOX_SIZE * 300));
+    outbox.ack(lastSeq);
+    TEST_ASSERT_EQUAL(1, outbox.pending());
+
+    // A stale ack for rows that are already gone changes nothing
+    outbox.ack(lastSeq);
+    TEST_ASSERT_EQUAL(1, outbox.pending());
+}
+
+void test_small_buffer_sends_oldest_first()
+{
+    uint8_t out[2 * TELEMETRY_PAYLOAD_SIZE + 8];
+    Outbox outbox;
+    uint32_t lastSeq;
+
+    for (unsigned long i = 0; i < 5; i++)
+        outbox.push(row(i * 300));
+
+    TEST_ASSERT_NOT_EQUAL(0, outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq));
+    TEST_ASSERT_EQUAL(1, lastSeq);
+    outbox.ack(lastSeq);
+    TEST_ASSERT_EQUAL(3, outbox.pending());
+}
+
+void test_cbor_batch_decodes()
+{
+    static uint8_t out[OUTBOX_BATCH_SIZE];
+    char id[TELEMETRY_PAYLOAD_SIZE];
+    Measurement rows[OUTBOX_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+    size_t n;
+
+    for (unsigned long i = 0; i < 4; i++)
+        outbox.push(row(1733843700 + i * 300));
+
+    n = outbox.encode(ENCODING_CBOR, out, sizeof(out), UUID, lastSeq);
+    TEST_ASSERT_EQUAL(4, decodeCborBatch(out, n, id, sizeof(id), rows, OUTBOX_SIZE));
+    TEST_ASSERT_EQUAL(1733843700 + 900, rows[3].epoch);
+}
+
+void test_rows_carry_boot_and_sequence()
+{
+    static uint8_t out[OUTBOX_BATCH_SIZE];
+    char id[TELEMETRY_ID_SIZE];
+    Measurement rows[OUTBOX_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+    size_t n;
+
+    outbox.begin(7);
+    outbox.push(row(1733843700));
+    outbox.push(row(1733844000));
+
+    n = outbox.encode(ENCODING_CBOR, out, sizeof(out), UUID, lastSeq);
+    TEST_ASSERT_EQUAL(2, decodeCborBatch(out, n, id, sizeof(id), rows, OUTBOX_SIZE));
+    TEST_ASSERT_TRUE(rows[0].seq == (7ULL << 32));
+    TEST_ASSERT_TRUE(rows[1].seq == ((7ULL << 32) | 1));
+
+    outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq);
+    TEST_ASSERT_NOT_NULL(strstr((const char *)out, "\"seq\":30064771073,"));
+}
+
+void test_encode_limits_rows()
+{
+    static uint8_t out[OUTBOX_BATCH_SIZE];
+    Outbox outbox;
+    uint32_t lastSeq;
+
+    for (unsigned long i = 0; i < 3; i++)
+        outbox.push(row(i * 300));
+
+    TEST_ASSERT_NOT_EQUAL(0, outbox.encode(ENCODING_JSON, out, sizeof(out), UUID, lastSeq, 1));
+    TEST_ASSERT_EQUAL(0, lastSeq);
+    TEST_ASSERT_EQUAL(1, countRows((const char *)out));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_push_assigns_sequences);
+    RUN_TEST(test_encode_then_ack_retires_rows);
+    RUN_TEST(test_failed_upload_keeps_rows);
+    RUN_TEST(test_full_outbox_drops_oldest);
+    RUN_TEST(test_ack_after_drop_during_flight);
+    RUN_TEST(test_small_buffer_sends_oldest_first);
+    RUN_TEST(test_cbor_batch_decodes);
+    RUN_TEST(test_rows_carry_boot_and_sequence);
+    RUN_TEST(test_encode_limits_rows);
+    return UNITY_END();
+}
@@ -0,0 +1,208 @@
+#include <Fixtures.h>
+#include <PayloadCodec/PayloadCodec.h>
+#include <math.h>
+#include <string.h>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+static const Measurement sample = {26.5f, 7.12f, 35.0f, 6.84f, 1733843982, 0x0000000300000011ULL};
+
+void test_timestamp_is_iso8601_utc()
+{
+    char out[TELEMETRY_TIMESTAMP_SIZE];
+
+    TEST_ASSERT_EQUAL(20, formatTimestamp(out, sizeof(out), 1733843982));
+    TEST_ASSERT_EQUAL_STRING("2024-12-10T15:19:42Z", out);
+}
+
+void test_timestamp_rejects_short_buffer()
+{
+    char out[TELEMETRY_TIMESTAMP_SIZE - 1];
+
+    TEST_ASSERT_EQUAL(0, formatTimestamp(out, sizeof(out), 1733843982));
+}
+
+void test_json_row()
+{
+    char out[TELEMETRY_PAYLOAD_SIZE];
+    size_t n = buildPayload(out, sizeof(out), UUID, sample);
+
+    TEST_ASSERT_EQUAL_STRING("{\"env_id\":\"" UUID "\",\"seq\":12884901905,\"temp\":26.500,\"dissolved_oxygen\":6.840,"
+                             "\"turbidity\":0.350,\"ph\":7.120,\"created_at\":\"2024-12-10T15:19:42Z\"}",
+                             out);
+    TEST_ASSERT_EQUAL(strlen(out), n);
+}
+
+void test_json_row_nan_is_null()
+{
+    char out[TELEMETRY_PAYLOAD_SIZE];
+    Measurement m = sample;
+
+    m.ph = NAN;
+    TEST_ASSERT_NOT_EQUAL(0, buildPayload(out, sizeof(out), UUID, m));
+    TEST_ASSERT_NOT_NULL(strstr(out, "\"ph\":null,"));
+}
+
+void test_json_row_does_not_overflow()
+{
+    char out[TELEMETRY_PAYLOAD_SIZE];
+    size_t full = buildPayload(out, sizeof(out), UUID, sample);
+
+    TEST_ASSERT_EQUAL(0, buildPayload(out, full, UUID, sample));
+    TEST_ASSERT_EQUAL(full, buildPayload(out, full + 1, UUID, sample));
+}
+
+void test_cbor_uuid_row_round_trip()
+{
+    uint8_t out[CBOR_PAYLOAD_MAX];
+    char id[TELEMETRY_PAYLOAD_SIZE];
+    Measurement m;
+    size_t n = encodeCborPayload(out, sizeof(out), UUID, sample);
+
+    TEST_ASSERT_NOT_EQUAL(0, n);
+    TEST_ASSERT_TRUE(decodeCborPayload(out, n, id, sizeof(id), m));
+    TEST_ASSERT_EQUAL_STRING(UUID, id);
+    TEST_ASSERT_TRUE(sample.seq == m.seq);
+    TEST_ASSERT_EQUAL(sample.epoch, m.epoch);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, sample.temperature, m.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, sample.ph, m.ph);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, sample.turbidity, m.turbidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, sample.dissolvedOxygen, m.dissolvedOxygen);
+}
+
+void test_cbor_text_id_and_nan()
+{
+    uint8_t out[CBOR_PAYLOAD_MAX];
+    char id[TELEMETRY_PAYLOAD_SIZE];
+    Measurement in = sample, m;
+    size_t n;
+
+    in.dissolvedOxygen = NAN;
+    n = encodeCborPayload(out, sizeof(out), "tank-1", in);
+    TEST_ASSERT_NOT_EQUAL(0, n);
+    TEST_ASSERT_TRUE(decodeCborPayload(out, n, id, sizeof(id), m));
+    TEST_ASSERT_EQUAL_STRING("tank-1", id);
+    TEST_ASSERT_TRUE(isnan(m.dissolvedOxygen));
+}
+
+void test_cbor_rejects_truncated_input()
+{
+    uint8_t out[CBOR_PAYLOAD_MAX];
+    char id[TELEMETRY_PAYLOAD_SIZE];
+    Measurement m;
+    size_t n = encodeCborPayload(out, sizeof(out), UUID, sample);
+
+    for (size_t len = 0; len < n; len++)
+        TEST_ASSERT_FALSE(decodeCborPayload(out, len, id, sizeof(id), m));
+}
+
+void test_cbor_batch_round_trip()
+{
+    uint8_t out[3 * CBOR_PAYLOAD_MAX + 8];
+    char id[TELEMETRY_PAYLOAD_SIZE];
+    Measurement rows[4];
+    size_t pos = encodeCborArray(out, sizeof(out), 3);
+
+    for (unsigned long i = 0; i < 3; i++)
+    {
+        Measurement m = sample;
+        m.epoch += i * 300;
+        pos += encodeCborPayload(out + pos, sizeof(out) - pos, UUID, m);
+    }
+
+    TEST_ASSERT_EQUAL(3, decodeCborBatch(out, pos, id, sizeof(id), rows, 4));
+    TEST_ASSERT_EQUAL(sample.epoch + 600, rows[2].epoch);
+    TEST_ASSERT_EQUAL(0, decodeCborBatch(out, pos, id, sizeof(id), rows, 2));
+}
+
+void test_cbor_worst_case_row_fits_max()
+{
+    // The longest text id the device can hold, a 64-bit seq and readings that need 32-bit integers
+    const char *id = "aquarium-living-room-left-tank-00000001";
+    Measurement m = {-99999.0f, 99999.0f, -99999.0f, 99999.0f, 0xFFFFFFFFUL, 0xFFFFFFFFFFFFFFFFULL};
+    uint8_t out[CBOR_PAYLOAD_MAX + 16];
+
+    TEST_ASSERT_EQUAL(TELEMETRY_ID_SIZE - 1, strlen(id));
+    TEST_ASSERT_EQUAL(CBOR_PAYLOAD_MAX, encodeCborPayload(out, sizeof(out), id, m));
+    TEST_ASSERT_EQUAL(0, encodeCborPayload(out, CBOR_PAYLOAD_MAX - 1, id, m));
+}
+
+void test_cbor_rejects_oversized_id()
+{
+    uint8_t out[2 * CBOR_PAYLOAD_MAX];
+
+    TEST_ASSERT_EQUAL(0, encodeCborPayload(out, sizeof(out), "aquarium-living-room-left-tank-000000001", sample));
+}
+
+void test_non_finite_readings_are_null()
+{
+    char json[TELEMETRY_PAYLOAD_SIZE], id[TELEMETRY_ID_SIZE];
+    uint8_t cbor[CBOR_PAYLOAD_MAX];
+    Measurement in = {INFINITY, -INFINITY, 3e30f, -2e6f, 1733843982, 0}, m;
+    size_t n;
+
+    TEST_ASSERT_NOT_EQUAL(0, buildPayload(json, sizeof(json), UUID, in));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"temp\":null,\"dissolved_oxygen\":null,\"turbidity\":null,\"ph\":null,"));
+
+    n = encodeCborPayload(cbor, sizeof(cbor), UUID, in);
+    TEST_ASSERT_TRUE(decodeCborPayload(cbor, n, id, sizeof(id), m));
+    TEST_ASSERT_TRUE(isnan(m.temperature));
+    TEST_ASSERT_TRUE(isnan(m.ph));
+    TEST_ASSERT_TRUE(isnan(m.turbidity));
+    TEST_ASSERT_TRUE(isnan(m.dissolvedOxygen));
+}
+
+void test_json_worst_case_row_fits()
+{
+    char out[TELEMETRY_PAYLOAD_SIZE];
+    Measurement m = {-999999.9f, -999999.9f, -999999.9f, -999999.9f, 0xFFFFFFFFUL, 0xFFFFFFFFFFFFFFFFULL};
+
+    TEST_ASSERT_NOT_EQUAL(0, buildPayload(out, sizeof(out), "aquarium-living-room-left-tank-00000001", m));
+}
+
+void test_cbor_seq_needs_all_eight_bytes()
+{
+    uint8_t out[CBOR_PAYLOAD_MAX];
+    char id[TELEMETRY_ID_SIZE];
+    Measurement in = sample, m;
+    size_t n;
+
+    in.seq = 0x123456789ABCDEF0ULL;
+    n = encodeCborPayload(out, sizeof(out), "tank-1", in);
+    TEST_ASSERT_TRUE(decodeCborPayload(out, n, id, sizeof(id), m));
+    TEST_ASSERT_TRUE(in.seq == m.seq);
+
+    in.seq = 5;
+    n = encodeCborPayload(out, sizeof(out), "tank-1", in);
+    TEST_ASSERT_TRUE(decodeCborPayload(out, n, id, sizeof(id), m));
+    TEST_ASSERT_TRUE(m.seq == 5);
+}
+
+void test_content_type()
+{
+    TEST_ASSERT_EQUAL_STRING("application/json", payloadContentType(ENCODING_JSON));
+    TEST_ASSERT_EQUAL_STRING("application/cbor", payloadContentType(ENCODING_CBOR));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_timestamp_is_iso8601_utc);
+    RUN_TEST(test_timestamp_rejects_short_buffer);
+    RUN_TEST(test_json_row);
+    RUN_TEST(test_json_row_nan_is_null);
+    RUN_TEST(test_json_row_does_not_overflow);
+    RUN_TEST(test_cbor_uuid_row_round_trip);
+    RUN_TEST(test_cbor_text_id_and_nan);
+    RUN_TEST(test_cbor_rejects_truncated_input);
+    RUN_TEST(test_cbor_batch_round_trip);
+    RUN_TEST(test_cbor_worst_case_row_fits_max);
+    RUN_TEST(test_cbor_rejects_oversized_id);
+    RUN_TEST(test_non_finite_readings_are_null);
+    RUN_TEST(test_json_worst_case_row_fits);
+    RUN_TEST(test_cbor_seq_needs_all_eight_bytes);
+    RUN_TEST(test_content_type);
+    return UNITY_END();
+}
@@ -0,0 +1,234 @@
+#include <ArenaAllocator/ArenaAllocator.h>
+#include <Fixtures.h>
+#include <Realtime/RealtimeChannel.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define TOPIC "realtime:aquarium:" UUID
+
+class FakeSocket : public RealtimeSocket
+{
+public:
+    FakeSocket() : sent(0), up(true) { last[0] = '\0'; }
+
+    bool sendText(const char *text, size_t len) override
+    {
+        if (!up || len >= sizeof(last))
+            return false;
+        memcpy(last, text, len);
+        last[len] = '\0';
+        sent++;
+        return true;
+    }
+
+    // The ref of the last message, for building its reply
+    unsigned long lastRef()
+    {
+        JsonDocument doc;
+        deserializeJson(doc, last);
+        return strtoul(doc["ref"] | "0", nullptr, 10);
+    }
+
+    char last[REALTIME_MESSAGE_SIZE];
+    int sent;
+    bool up;
+};
+
+// Messages are built and parsed in an arena, the way the firmware does it
+static uint8_t arenaBuffer[8192];
+static ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+static uint32_t now;
+static int changes;
+static char changedName[32];
+
+static uint32_t clockMs()
+{
+    return now;
+}
+
+static void onChange(JsonVariantConst data)
+{
+    changes++;
+    strncpy(changedName, data["record"]["name"] | "", sizeof(changedName) - 1);
+}
+
+static void reply(RealtimeChannel &channel, unsigned long ref, const char *status)
+{
+    char text[160];
+    int n = snprintf(text, sizeof(text),
+                     "{\"topic\":\"" TOPIC "\",\"event\":\"phx_reply\",\"payload\":{\"status\":\"%s\",\"response\":{}},"
+                     "\"ref\":\"%lu\"}",
+                     status, ref);
+    channel.received(text, n, now);
+}
+
+void setUp()
+{
+    now = 1000;
+    changes = 0;
+    changedName[0] = '\0';
+}
+
+void tearDown() {}
+
+void test_endpoint_from_project_url()
+{
+    RealtimeEndpoint e;
+
+    TEST_ASSERT_TRUE(parseRealtimeEndpoint("https://abc.supabase.co", e));
+    TEST_ASSERT_EQUAL_STRING("abc.supabase.co", e.host);
+    TEST_ASSERT_EQUAL(443, e.port);
+    TEST_ASSERT_TRUE(e.secure);
+
+    TEST_ASSERT_TRUE(parseRealtimeEndpoint("http://192.168.1.10:54321", e));
+    TEST_ASSERT_EQUAL_STRING("192.168.1.10", e.host);
+    TEST_ASSERT_EQUAL(54321, e.port);
+    TEST_ASSERT_FALSE(e.secure);
+
+    TEST_ASSERT_FALSE(parseRealtimeEndpoint("ftp://abc", e));
+    TEST_ASSERT_FALSE(parseRealtimeEndpoint("http://host:70000", e));
+}
+
+void test_join_subscribes_to_the_aquarium_row()
+{
+    FakeSocket socket;
+    RealtimeChannel channel(socket, &arena);
+
+    channel.begin(UUID, "token", onChange);
+    channel.connected(now);
+
+    TEST_ASSERT_EQUAL(1, socket.sent);
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"event\":\"phx_join\""));
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"topic\":\"" TOPIC "\""));
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"filter\":\"id=eq." UUID "\""));
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"ack\":true"));
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"access_token\":\"token\""));
+    TEST_ASSERT_FALSE(channel.ready());
+
+    reply(channel, socket.lastRef(), "ok");
+    TEST_ASSERT_TRUE(channel.ready());
+}
+
+void test_presence_tracked_after_join()
+{
+    FakeSocket socket;
+    RealtimeChannel channel(socket, &arena);
+
+    channel.begin(UUID, nullptr, onChange);
+    channel.setPresence("Living room", "2024-12-10T15:19:42Z");
+    channel.connected(now);
+    reply(channel, socket.lastRef(), "ok");
+
+    channel.poll(now);
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"event\":\"track\""));
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"name\":\"Living room\""));
+}
+
+void test_broadcast_acked_by_reply()
+{
+    FakeSocket socket;
+    RealtimeChannel channel(socket, &arena);
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+
+    channel.begin(UUID, nullptr, onChange);
+    channel.setUplink(&uplink);
+    uplink.setTransports(&channel, nullptr);
+    channel.connected(now);
+    reply(channel, socket.lastRef(), "ok");
+
+    outbox.begin(2);
+    outbox.push(row(1733843700));
+    uplink.poll();
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"event\":\"broadcast\""));
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"event\":\"" REALTIME_BROADCAST_EVENT "\""));
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"rows\":[{\"env_id\":\"" UUID "\",\"seq\":8589934592,"));
+    TEST_ASSERT_TRUE(uplink.busy());
+
+    now += 80;
+    reply(channel, socket.lastRef(), "ok");
+    TEST_ASSERT_FALSE(uplink.busy());
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+    TEST_ASSERT_EQUAL(80, uplink.stats().lastLatencyMs);
+}
+
+void test_channel_error_fails_pending_broadcast()
+{
+    FakeSocket socket;
+    RealtimeChannel channel(socket, &arena);
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+
+    channel.begin(UUID, nullptr, onChange);
+    channel.setUplink(&uplink);
+    uplink.setTransports(&channel, nullptr);
+    channel.connected(now);
+    reply(channel, socket.lastRef(), "ok");
+
+    outbox.push(row(1733843700));
+    uplink.poll();
+    const char *error = "{\"topic\":\"" TOPIC "\",\"event\":\"phx_error\",\"payload\":{},\"ref\":null}";
+    channel.received(error, strlen(error), now);
+    TEST_ASSERT_FALSE(uplink.busy());
+    TEST_ASSERT_EQUAL(1, uplink.stats().failed);
+    TEST_ASSERT_EQUAL(1, outbox.pending());
+
+    // The channel rejoins on its own
+    now += REALTIME_REJOIN_MS;
+    channel.poll(now);
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"event\":\"phx_join\""));
+}
+
+void test_postgres_changes_reach_the_handler()
+{
+    FakeSocket socket;
+    RealtimeChannel channel(socket, &arena);
+    const char *message = "{\"topic\":\"" TOPIC "\",\"event\":\"postgres_changes\",\"payload\":{\"data\":"
+                          "{\"type\":\"UPDATE\",\"record\":{\"id\":\"" UUID "\",\"name\":\"Reef\"}},\"ids\":[1]},\"ref\":null}";
+
+    channel.begin(UUID, nullptr, onChange);
+    channel.connected(now);
+    channel.received(message, strlen(message), now);
+    TEST_ASSERT_EQUAL(1, changes);
+    TEST_ASSERT_EQUAL_STRING("Reef", changedName);
+}
+
+void test_unanswered_heartbeat_is_unhealthy()
+{
+    FakeSocket socket;
+    RealtimeChannel channel(socket, &arena);
+
+    channel.begin(UUID, nullptr, onChange);
+    channel.connected(now);
+    reply(channel, socket.lastRef(), "ok");
+
+    now += REALTIME_HEARTBEAT_MS;
+    channel.poll(now);
+    TEST_ASSERT_NOT_NULL(strstr(socket.last, "\"event\":\"heartbeat\""));
+    reply(channel, socket.lastRef(), "ok");
+    TEST_ASSERT_TRUE(channel.healthy());
+
+    now += REALTIME_HEARTBEAT_MS;
+    channel.poll(now);
+    now += REALTIME_HEARTBEAT_MS;
+    channel.poll(now);
+    TEST_ASSERT_FALSE(channel.healthy());
+
+    channel.disconnected();
+    TEST_ASSERT_TRUE(channel.healthy());
+    TEST_ASSERT_FALSE(channel.ready());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_endpoint_from_project_url);
+    RUN_TEST(test_join_subscribes_to_the_aquarium_row);
+    RUN_TEST(test_presence_tracked_after_join);
+    RUN_TEST(test_broadcast_acked_by_reply);
+    RUN_TEST(test_channel_error_fails_pending_broadcast);
+    RUN_TEST(test_postgres_changes_reach_the_handler);
+    RUN_TEST(test_unanswered_heartbeat_is_unhealthy);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+#include <Schedule/Schedule.h>
+#include <string.h>
+#include <unity.h>
+
+#define BOUNDARY 1733843700UL // 2024-12-10T15:15:00Z, a multiple of UPLOAD_PERIOD
+
+void setUp() {}
+void tearDown() {}
+
+// Ticks once a second from epoch over seconds, the way the loop does, and counts recordings
+static uint32_t recordings(DeviceSchedule &schedule, unsigned long epoch, uint32_t seconds, bool syncEnable = true)
+{
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < seconds; i++)
+        n += (schedule.tick(epoch + i, syncEnable) & SCHEDULE_RECORD) != 0;
+    return n;
+}
+
+void test_samples_after_more_than_an_interval()
+{
+    DeviceSchedule schedule;
+
+    schedule.begin(5000);
+    TEST_ASSERT_FALSE(schedule.sampleDue(5000 + SAMPLE_INTERVAL));
+    TEST_ASSERT_EQUAL(1, schedule.untilSample(5000 + SAMPLE_INTERVAL));
+    TEST_ASSERT_TRUE(schedule.sampleDue(5001 + SAMPLE_INTERVAL));
+    TEST_ASSERT_FALSE(schedule.sampleDue(5002 + SAMPLE_INTERVAL));
+    TEST_ASSERT_EQUAL(SAMPLE_INTERVAL, schedule.untilSample(5002 + SAMPLE_INTERVAL));
+
+    // A late loop pass gets one tick, not a burst to catch up
+    TEST_ASSERT_TRUE(schedule.sampleDue(20000));
+    TEST_ASSERT_FALSE(schedule.sampleDue(20001));
+    TEST_ASSERT_EQUAL(0, schedule.untilSample(30000));
+}
+
+void test_sample_timer_survives_millis_wrap()
+{
+    DeviceSchedule schedule;
+
+    schedule.begin(0xFFFFFF00);
+    TEST_ASSERT_FALSE(schedule.sampleDue(0x100));
+    TEST_ASSERT_TRUE(schedule.sampleDue(0xFFFFFF00 + SAMPLE_INTERVAL + 1));
+}
+
+void test_records_once_per_period()
+{
+    DeviceSchedule schedule;
+
+    // The whole recording minute ticks, one row comes out of it
+    TEST_ASSERT_EQUAL(1, recordings(schedule, BOUNDARY, 60));
+    TEST_ASSERT_EQUAL(0, recordings(schedule, BOUNDARY + 60, UPLOAD_PERIOD - 60));
+    TEST_ASSERT_EQUAL(3, recordings(schedule, BOUNDARY + UPLOAD_PERIOD, 3 * UPLOAD_PERIOD));
+}
+
+void test_late_tick_in_the_minute_still_records()
+{
+    DeviceSchedule schedule;
+
+    TEST_ASSERT_EQUAL(0, recordings(schedule, BOUNDARY - 30, 30));
+    TEST_ASSERT_EQUAL(SCHEDULE_RECORD, schedule.tick(BOUNDARY + 59, true) & SCHEDULE_RECORD);
+}
+
+void test_nothing_before_the_clock_is_valid()
+{
+    DeviceSchedule schedule;
+
+    // NTPClient counts from 1970 until it first syncs, minute 0 of that must not record
+    TEST_ASSERT_EQUAL(0, schedule.tick(0, true));
+    TEST_ASSERT_EQUAL(0, schedule.tick(MIN_VALID_EPOCH - UPLOAD_PERIOD, true));
+    TEST_ASSERT_EQUAL_STRING("", schedule.joinedAt());
+}
+
+void test_joined_once_when_the_clock_becomes_valid()
+{
+    DeviceSchedule schedule;
+    const char *joinedAt = schedule.joinedAt();
+
+    TEST_ASSERT_EQUAL(SCHEDULE_JOINED, schedule.tick(BOUNDARY + 120, true));
+    TEST_ASSERT_EQUAL_STRING("2024-12-10T15:17:00Z", schedule.joinedAt());
+    TEST_ASSERT_EQUAL(0, schedule.tick(BOUNDARY + UPLOAD_PERIOD + 120, true));
+    TEST_ASSERT_EQUAL_STRING("2024-12-10T15:17:00Z", schedule.joinedAt());
+    // Presence keeps the pointer
+    TEST_ASSERT_EQUAL_PTR(joinedAt, schedule.joinedAt());
+
+    DeviceSchedule onBoundary;
+    TEST_ASSERT_EQUAL(SCHEDULE_JOINED | SCHEDULE_RECORD, onBoundary.tick(BOUNDARY, true));
+}
+
+void test_sync_disabled_skips_until_enabled()
+{
+    DeviceSchedule schedule;
+
+    TEST_ASSERT_EQUAL(0, recordings(schedule, BOUNDARY, 20, false));
+    // Turned on within the minute, the period still gets its row
+    TEST_ASSERT_EQUAL(1, recordings(schedule, BOUNDARY + 20, 40));
+}
+
+void test_slot_moves_the_recording()
+{
+    DeviceSchedule schedule(90);
+
+    TEST_ASSERT_EQUAL(0, recordings(schedule, BOUNDARY, 90));
+    TEST_ASSERT_EQUAL(1, recordings(schedule, BOUNDARY + 90, UPLOAD_PERIOD));
+}
+
+void test_sign_in_retry()
+{
+    SignInRetry retry;
+
+    retry.begin(1000);
+    TEST_ASSERT_TRUE(retry.due(1000));
+    retry.failed(1000);
+    TEST_ASSERT_FALSE(retry.due(1000 + SIGN_IN_RETRY_MS - 1));
+    TEST_ASSERT_TRUE(retry.due(1000 + SIGN_IN_RETRY_MS));
+
+    retry.failed(0xFFFFF000);
+    TEST_ASSERT_FALSE(retry.due(0x10));
+    TEST_ASSERT_TRUE(retry.due(0xFFFFF000 + SIGN_IN_RETRY_MS));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_samples_after_more_than_an_interval);
+    RUN_TEST(test_sample_timer_survives_millis_wrap);
+    RUN_TEST(test_records_once_per_period);
+    RUN_TEST(test_late_tick_in_the_minute_still_records);
+    RUN_TEST(test_nothing_before_the_clock_is_valid);
+    RUN_TEST(test_joined_once_when_the_clock_becomes_valid);
+    RUN_TEST(test_sync_disabled_skips_until_enabled);
+    RUN_TEST(test_slot_moves_the_recording);
+    RUN_TEST(test_sign_in_retry);
+    return UNITY_END();
+}
@@ -0,0 +1,182 @@
+#include <Crc32/Crc32.h>
+#include <SensorTrace/TraceCodec.h>
+#include <string.h>
+#include <unity.h>
+
+#define SAMPLES 5
+
+void setUp() {}
+void tearDown() {}
+
+static RawSample sampleAt(uint32_t i)
+{
+    RawSample s = {1000 + i * 1000, 24.5f + i, (uint16_t)(1800 + i), (uint16_t)(900 + i), (uint16_t)(600 + i)};
+    return s;
+}
+
+// Header and SAMPLES records, the way traceAppend() lays out a capture file
+static size_t buildTrace(uint8_t *out)
+{
+    traceEncodeHeader(out);
+    for (uint32_t i = 0; i < SAMPLES; i++)
+        traceEncodeSample(out + TRACE_HEADER_SIZE + i * TRACE_RECORD_SIZE, sampleAt(i));
+    return TRACE_HEADER_SIZE + SAMPLES * TRACE_RECORD_SIZE;
+}
+
+static RawSample replayed[SAMPLES + 1];
+static uint32_t replayedCount;
+
+static void collect(const RawSample &sample)
+{
+    if (replayedCount < SAMPLES + 1)
+        replayed[replayedCount] = sample;
+    replayedCount++;
+}
+
+void test_record_layout_is_packed_little_endian()
+{
+    const uint8_t expected[TRACE_RECORD_SIZE] = {0x78, 0x56, 0x34, 0x12, 0x00, 0x00, 0xC8, 0x41,
+                                                 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    RawSample s = {0x12345678, 25.0f, 0x0201, 0x0403, 0x0605};
+    uint8_t record[TRACE_RECORD_SIZE];
+
+    traceEncodeSample(record, s);
+    TEST_ASSERT_EQUAL_MEMORY(expected, record, TRACE_RECORD_SIZE);
+}
+
+void test_record_round_trip()
+{
+    RawSample in = sampleAt(3), out;
+    uint8_t record[TRACE_RECORD_SIZE];
+
+    traceEncodeSample(record, in);
+    traceDecodeSample(record, out);
+    TEST_ASSERT_EQUAL(in.timestamp, out.timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(in.temperature, out.temperature);
+    TEST_ASSERT_EQUAL(in.ph, out.ph);
+    TEST_ASSERT_EQUAL(in.turbidity, out.turbidity);
+    TEST_ASSERT_EQUAL(in.dissolvedOxygen, out.dissolvedOxygen);
+}
+
+void test_replay_feeds_every_record_in_order()
+{
+    uint8_t trace[TRACE_HEADER_SIZE + SAMPLES * TRACE_RECORD_SIZE];
+    MemoryTraceSource source(trace, buildTrace(trace));
+
+    replayedCount = 0;
+    TraceReplayResult result = traceReplay(source, collect);
+
+    TEST_ASSERT_TRUE(result.ok);
+    TEST_ASSERT_EQUAL(SAMPLES, result.samples);
+    TEST_ASSERT_EQUAL(SAMPLES, replayedCount);
+    TEST_ASSERT_EQUAL((SAMPLES - 1) * 1000, result.tracedMs);
+    for (uint32_t i = 0; i < SAMPLES; i++)
+    {
+        TEST_ASSERT_EQUAL(sampleAt(i).timestamp, replayed[i].timestamp);
+        TEST_ASSERT_EQUAL(sampleAt(i).ph, replayed[i].ph);
+    }
+}
+
+void test_replay_rejects_other_files()
+{
+    uint8_t trace[TRACE_HEADER_SIZE + SAMPLES * TRACE_RECORD_SIZE];
+    size_t size = buildTrace(trace);
+
+    trace[5] = TRACE_RECORD_SIZE + 2; // records from a different layout
+    MemoryTraceSource other(trace, size);
+    replayedCount = 0;
+    TEST_ASSERT_FALSE(traceReplay(other, collect).ok);
+    TEST_ASSERT_EQUAL(0, replayedCount);
+
+    MemoryTraceSource empty(trace, 3);
+    TEST_ASSERT_FALSE(traceReplay(empty, collect).ok);
+}
+
+void test_replay_ignores_a_partial_last_record()
+{
+    uint8_t trace[TRACE_HEADER_SIZE + SAMPLES * TRACE_RECORD_SIZE];
+    // A capture cut off mid-write by a reset
+    MemoryTraceSource source(trace, buildTrace(trace) - 5);
+
+    replayedCount = 0;
+    TraceReplayResult result = traceReplay(source, collect);
+
+    TEST_ASSERT_TRUE(result.ok);
+    TEST_ASSERT_EQUAL(SAMPLES - 1, result.samples);
+    TEST_ASSERT_EQUAL(SAMPLES - 1, replayedCount);
+}
+
+void test_stepped_replay_matches_one_pass()
+{
+    uint8_t trace[TRACE_HEADER_SIZE + SAMPLES * TRACE_RECORD_SIZE];
+    MemoryTraceSource source(trace, buildTrace(trace));
+    TraceReplay replay;
+    RawSample sample;
+    uint32_t n = 0;
+
+    TEST_ASSERT_TRUE(replay.begin(source));
+    // Two records per pass, the way the firmware spreads a replay over its loop
+    for (;;)
+    {
+        bool more = true;
+        for (int i = 0; i < 2 && (more = replay.next(sample)); i++)
+            TEST_ASSERT_EQUAL(sampleAt(n++).timestamp, sample.timestamp);
+        if (!more)
+            break;
+    }
+    TEST_ASSERT_EQUAL(SAMPLES, n);
+    TEST_ASSERT_EQUAL(SAMPLES, replay.samples());
+    TEST_ASSERT_EQUAL((SAMPLES - 1) * 1000, replay.tracedMs());
+    TEST_ASSERT_FALSE(replay.next(sample));
+}
+
+void test_frame_layout()
+{
+    RawSample samples[2] = {sampleAt(0), sampleAt(1)};
+    uint8_t frame[TRACE_FRAME_SIZE(2)];
+    uint32_t crc;
+
+    TEST_ASSERT_EQUAL(TRACE_FRAME_SIZE(2), traceEncodeFrame(frame, 0x01020304, samples, 2));
+    TEST_ASSERT_EQUAL_HEX8(0xA5, frame[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, frame[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x04, frame[2]); // first seq, little endian
+    TEST_ASSERT_EQUAL_HEX8(0x01, frame[5]);
+    TEST_ASSERT_EQUAL(2, frame[6]);
+
+    for (int i = 0; i < 2; i++)
+    {
+        RawSample sample;
+        traceDecodeSample(frame + TRACE_FRAME_HEADER_SIZE + i * TRACE_RECORD_SIZE, sample);
+        TEST_ASSERT_EQUAL(samples[i].timestamp, sample.timestamp);
+        TEST_ASSERT_EQUAL(samples[i].dissolvedOxygen, sample.dissolvedOxygen);
+    }
+
+    // The CRC covers seq, count and records, not the sync bytes
+    memcpy(&crc, frame + TRACE_FRAME_SIZE(2) - 4, 4);
+    TEST_ASSERT_EQUAL_HEX32(crc32Update(0, frame + 2, TRACE_FRAME_SIZE(2) - 6), crc);
+}
+
+void test_empty_frame_ends_the_export()
+{
+    uint8_t frame[TRACE_FRAME_SIZE(0)];
+    uint32_t crc;
+
+    TEST_ASSERT_EQUAL(11, traceEncodeFrame(frame, 42, nullptr, 0));
+    TEST_ASSERT_EQUAL(0, frame[6]);
+    memcpy(&crc, frame + 7, 4);
+    TEST_ASSERT_EQUAL_HEX32(crc32Update(0, frame + 2, 5), crc);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_record_layout_is_packed_little_endian);
+    RUN_TEST(test_record_round_trip);
+    RUN_TEST(test_replay_feeds_every_record_in_order);
+    RUN_TEST(test_replay_rejects_other_files);
+    RUN_TEST(test_replay_ignores_a_partial_last_record);
+    RUN_TEST(test_stepped_replay_matches_one_pass);
+    RUN_TEST(test_frame_layout);
+    RUN_TEST(test_empty_frame_ends_the_export);
+    return UNITY_END();
+}
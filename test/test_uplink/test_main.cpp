@@ -0,0 +1,235 @@
+#include <Fixtures.h>
+#include <Uplink/Uplink.h>
+#include <unity.h>
+
+static uint32_t now;
+
+static uint32_t clockMs()
+{
+    return now;
+}
+
+class FakeTransport : public UplinkTransport
+{
+public:
+    FakeTransport(size_t rows, DeliveryResult result) : up(true), rows(rows), result(result), calls(0), lastSeq(0) {}
+
+    bool ready() override { return up; }
+    size_t capacity() const override { return rows; }
+
+    DeliveryResult deliver(const Outbox &outbox, const char *, uint32_t &seq) override
+    {
+        size_t n = outbox.pending() < rows ? outbox.pending() : rows;
+
+        calls++;
+        seq = lastSeq = outbox.oldest() + n - 1;
+        return result;
+    }
+
+    bool up;
+    size_t rows;
+    DeliveryResult result;
+    int calls;
+    uint32_t lastSeq;
+};
+
+void setUp()
+{
+    now = 1000;
+}
+
+void tearDown() {}
+
+void test_single_row_goes_over_primary()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport realtime(1, DELIVERY_PENDING), http(OUTBOX_SIZE, DELIVERY_ACKED);
+
+    uplink.setTransports(&realtime, &http);
+    outbox.push(row(0));
+    uplink.poll();
+    TEST_ASSERT_EQUAL(1, realtime.calls);
+    TEST_ASSERT_TRUE(uplink.busy());
+
+    // Nothing else starts while the broadcast waits for its ack
+    outbox.push(row(300));
+    uplink.poll();
+    TEST_ASSERT_EQUAL(0, http.calls);
+
+    now += 120;
+    uplink.complete(&realtime, realtime.lastSeq, true);
+    TEST_ASSERT_FALSE(uplink.busy());
+    TEST_ASSERT_EQUAL(1, outbox.pending());
+    TEST_ASSERT_EQUAL(1, uplink.stats().primary);
+    TEST_ASSERT_EQUAL(120, uplink.stats().lastLatencyMs);
+}
+
+void test_backlog_goes_over_fallback()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport realtime(1, DELIVERY_PENDING), http(OUTBOX_SIZE, DELIVERY_ACKED);
+
+    uplink.setTransports(&realtime, &http);
+    for (unsigned long i = 0; i < 5; i++)
+        outbox.push(row(i * 300));
+
+    uplink.poll();
+    TEST_ASSERT_EQUAL(0, realtime.calls);
+    TEST_ASSERT_EQUAL(1, http.calls);
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+    TEST_ASSERT_EQUAL(5, uplink.stats().rows);
+    TEST_ASSERT_EQUAL(1, uplink.stats().fallback);
+}
+
+void test_unanswered_broadcast_falls_back()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport realtime(1, DELIVERY_PENDING), http(OUTBOX_SIZE, DELIVERY_ACKED);
+
+    uplink.setTransports(&realtime, &http);
+    outbox.push(row(0));
+    uplink.poll();
+
+    now += UPLINK_ACK_TIMEOUT_MS - 1;
+    uplink.poll();
+    TEST_ASSERT_EQUAL(0, http.calls);
+
+    now += 1;
+    uplink.poll();
+    TEST_ASSERT_EQUAL(1, uplink.stats().timeouts);
+    TEST_ASSERT_EQUAL(1, http.calls);
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+
+    // The late ack no longer matches anything in flight
+    uplink.complete(&realtime, realtime.lastSeq, true);
+    TEST_ASSERT_EQUAL(1, uplink.stats().sent);
+}
+
+void test_failures_back_off_exponentially()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport http(OUTBOX_SIZE, DELIVERY_FAILED);
+
+    uplink.setTransports(nullptr, &http);
+    outbox.push(row(0));
+
+    uplink.poll();
+    TEST_ASSERT_EQUAL(UPLINK_RETRY_MIN_MS, uplink.backoffMs());
+
+    now += UPLINK_RETRY_MIN_MS - 1;
+    uplink.poll();
+    TEST_ASSERT_EQUAL(1, http.calls);
+
+    now += 1;
+    uplink.poll();
+    TEST_ASSERT_EQUAL(2, http.calls);
+    TEST_ASSERT_EQUAL(2 * UPLINK_RETRY_MIN_MS, uplink.backoffMs());
+
+    for (int i = 0; i < 20; i++)
+    {
+        now += UPLINK_RETRY_MAX_MS;
+        uplink.poll();
+    }
+    TEST_ASSERT_EQUAL(UPLINK_RETRY_MAX_MS, uplink.backoffMs());
+    TEST_ASSERT_EQUAL(1, outbox.pending());
+
+    http.result = DELIVERY_ACKED;
+    now += UPLINK_RETRY_MAX_MS;
+    uplink.poll();
+    TEST_ASSERT_EQUAL(0, uplink.backoffMs());
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+}
+
+void test_nothing_ready_waits()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport realtime(1, DELIVERY_PENDING), http(OUTBOX_SIZE, DELIVERY_ACKED);
+
+    realtime.up = false;
+    http.up = false;
+    uplink.setTransports(&realtime, &http);
+    outbox.push(row(0));
+    uplink.poll();
+    TEST_ASSERT_EQUAL(0, uplink.stats().attempts);
+
+    // Rows recorded while the link was down go out once it is back
+    outbox.push(row(300));
+    http.up = true;
+    uplink.poll();
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+}
+
+void test_primary_drains_backlog_without_fallback()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport realtime(1, DELIVERY_ACKED);
+
+    uplink.setTransports(&realtime, nullptr);
+    outbox.push(row(0));
+    outbox.push(row(300));
+    uplink.poll();
+    uplink.poll();
+    TEST_ASSERT_EQUAL(2, realtime.calls);
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+}
+
+// TRANSPORT_HTTP: the batch transport alone, new rows and backlog alike
+void test_batch_transport_alone_carries_everything()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport http(OUTBOX_SIZE, DELIVERY_ACKED);
+
+    uplink.setTransports(&http, nullptr);
+    outbox.push(row(0));
+    uplink.poll();
+    TEST_ASSERT_EQUAL(1, http.calls);
+    outbox.push(row(300));
+    outbox.push(row(600));
+    uplink.poll();
+    TEST_ASSERT_EQUAL(2, http.calls);
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+    TEST_ASSERT_EQUAL(3, uplink.stats().rows);
+}
+
+void test_refused_broadcast_retries_over_fallback()
+{
+    Outbox outbox;
+    Uplink uplink(outbox, UUID, clockMs);
+    FakeTransport realtime(1, DELIVERY_PENDING), http(OUTBOX_SIZE, DELIVERY_ACKED);
+
+    uplink.setTransports(&realtime, &http);
+    outbox.push(row(0));
+    uplink.poll();
+    uplink.complete(&realtime, realtime.lastSeq, false);
+    TEST_ASSERT_EQUAL(0, uplink.backoffMs());
+
+    uplink.poll();
+    TEST_ASSERT_EQUAL(1, http.calls);
+    TEST_ASSERT_EQUAL(0, outbox.pending());
+
+    // Once something got through the next fresh row uses the broadcast again
+    outbox.push(row(300));
+    uplink.poll();
+    TEST_ASSERT_EQUAL(2, realtime.calls);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_single_row_goes_over_primary);
+    RUN_TEST(test_backlog_goes_over_fallback);
+    RUN_TEST(test_unanswered_broadcast_falls_back);
+    RUN_TEST(test_failures_back_off_exponentially);
+    RUN_TEST(test_nothing_ready_waits);
+    RUN_TEST(test_primary_drains_backlog_without_fallback);
+    RUN_TEST(test_batch_transport_alone_carries_everything);
+    RUN_TEST(test_refused_broadcast_retries_over_fallback);
+    return UNITY_END();
+}
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Decodes the binary frames the console `dump` command streams into CSV of raw samples.
+
+Frame layout (src/SensorTrace/TraceCodec.h), all fields little endian:
+
+  0xA5 0x5A | first seq (u32) | count (u8) | count 14-byte records | CRC32 of seq..records (u32)
+  record:   t_ms (u32) | temperature (f32) | ph (u16) | turbidity (u16) | dissolved oxygen (u16)
+
+A frame with count 0 ends the export. Bytes around the frames (the echoed command, log lines once the
+export ends) are skipped, so a plain capture of the serial port works:
+
+  stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > dump.bin   # then send `dump` to the device
+  python3 tools/export/decode_export.py dump.bin > samples.csv
+
+Samples the device overwrote while exporting show up as a gap in seq and are reported on stderr, as
+are frames that fail their CRC. Only the standard library is needed.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+SYNC = b"\xa5\x5a"
+HEADER = struct.Struct("<IB")  # first seq, count, after the sync bytes
+RECORD = struct.Struct("<IfHHH")
+CRC = struct.Struct("<I")
+
+
+def frames(data):
+    """Yields (first seq, records) per valid frame, (None, None) for a corrupt one."""
+    pos = 0
+    while True:
+        pos = data.find(SYNC, pos)
+        if pos < 0 or pos + 2 + HEADER.size > len(data):
+            return
+        first, count = HEADER.unpack_from(data, pos + 2)
+        end = pos + 2 + HEADER.size + count * RECORD.size
+        if end + CRC.size > len(data):
+            return
+        (crc,) = CRC.unpack_from(data, end)
+        if zlib.crc32(data[pos + 2:end]) != crc:
+            yield None, None
+            pos += 1  # a sync pattern inside a record or a damaged frame, look for the next one
+            continue
+        yield first, [RECORD.unpack_from(data, pos + 2 + HEADER.size + i * RECORD.size) for i in range(count)]
+        pos = end + CRC.size
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", help="raw serial capture, - for stdin")
+    args = parser.parse_args()
+
+    stream = sys.stdin.buffer if args.capture == "-" else open(args.capture, "rb")
+    with stream:
+        data = stream.read()
+
+    out = sys.stdout
+    out.write("seq,t_ms,temp,ph_raw,turbidity_raw,do_raw\n")
+    expected, samples, corrupt, ended = None, 0, 0, False
+    for first, records in frames(data):
+        if first is None:
+            corrupt += 1
+            continue
+        if not records:
+            ended = True
+            break
+        if expected is not None and first != expected:
+            print(f"gap: seq {expected} to {first - 1} missing", file=sys.stderr)
+        for i, (t_ms, temp, ph, turbidity, do) in enumerate(records):
+            out.write(f"{first + i},{t_ms},{temp:.2f},{ph},{turbidity},{do}\n")
+        samples += len(records)
+        expected = first + len(records)
+
+    print(f"{samples} samples, {corrupt} corrupt frames{'' if ended else ', no end frame (capture cut short?)'}",
+          file=sys.stderr)
+    return 0 if ended and corrupt == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,515 @@
+#!/usr/bin/env python3
+"""Local stand-in for the Supabase endpoints the firmware uses, with fault injection.
+
+Serves on one port, like `supabase start` does on :54321:
+
+  POST  /auth/v1/token?grant_type=password|refresh_token   GoTrue sign-in, any credentials
+  POST  /rest/v1/measurements                               JSON or CBOR rows, optionally deflated,
+                                                            upserted on (env_id, seq), the index
+                                                            supabase/migrations adds
+  GET   /rest/v1/measurements[?env_id=eq.<id>]              stored rows
+  PATCH /rest/v1/aquarium?id=eq.<id>                        merges the JSON body into the row and
+                                                            pushes a postgres_changes UPDATE
+  GET   /stats                                              counters, see Stats
+  GET   /realtime/v1/websocket                              Phoenix channels: join, heartbeat,
+                                                            presence, broadcast with ack
+
+Broadcasts are relayed and acked but not stored, the same as Supabase. With --ingest-broadcasts
+`measurement` events are persisted like REST inserts, standing in for an ingest subscriber on the
+channel; only a stack that has one can take TELEMETRY_TRANSPORT=TRANSPORT_REALTIME.
+
+Faults apply to every REST request but /stats and to every websocket message:
+
+  --latency-ms / --jitter-ms   delay before answering
+  --error-rate                 REST answers 503, broadcasts are acked with status "error"
+  --drop-rate                  no answer at all: REST connection closed, broadcast ack withheld
+  --disconnect-rate            websocket closed right after receiving a message
+
+Only the standard library is needed:
+
+  python3 tools/standin/standin.py --port 54321 --error-rate 0.05 --disconnect-rate 0.01
+  AQUA_SUPABASE_HOST=http://<this machine>:54321 AQUA_SUPABASE_KEY=local pio run -e esp32dev_local
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import json
+import random
+import struct
+import time
+import uuid
+import zlib
+from datetime import datetime, timezone
+from urllib.parse import parse_qs, urlsplit
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+BROADCAST_EVENT = "measurement"
+
+
+class Stats:
+    def __init__(self):
+        self.started = time.monotonic()
+        self.requests = 0
+        self.rest_batches = 0
+        self.rows_inserted = 0
+        self.duplicates = 0
+        self.broadcasts = 0
+        self.sockets_opened = 0
+        self.sockets_open = 0
+        self.joins = 0
+        self.heartbeats = 0
+        self.injected_errors = 0
+        self.injected_drops = 0
+        self.injected_disconnects = 0
+        self.per_second = {}  # wall clock second -> uploads (REST batches and ingested broadcasts)
+
+    def upload(self):
+        second = int(time.time())
+        self.per_second[second] = self.per_second.get(second, 0) + 1
+        # Keep an hour, enough for a fleet run across several five minute boundaries
+        if len(self.per_second) > 3600:
+            for key in sorted(self.per_second)[:-3600]:
+                del self.per_second[key]
+
+    def as_dict(self, store, presence):
+        data = {k: v for k, v in vars(self).items() if k not in ("started", "per_second")}
+        data["uptime_s"] = round(time.monotonic() - self.started, 1)
+        data["rows_stored"] = len(store.rows)
+        data["presence"] = sum(len(p) for p in presence.values())
+        data["peak_uploads_per_s"] = max(self.per_second.values(), default=0)
+        return data
+
+
+class Store:
+    """measurements with a unique (env_id, seq), aquarium rows by id."""
+
+    def __init__(self, stats):
+        self.stats = stats
+        self.rows = {}
+        self.next_id = 1
+        self.aquariums = {}
+
+    def upsert(self, rows):
+        for row in rows:
+            seq = row.get("seq")
+            key = (row.get("env_id"), seq) if seq is not None else ("", -self.next_id)
+            if key in self.rows:
+                self.stats.duplicates += 1
+                continue
+            row = dict(row, id=self.next_id)
+            self.next_id += 1
+            self.rows[key] = row
+            self.stats.rows_inserted += 1
+
+    def select(self, env_id=None):
+        return [r for (e, _), r in sorted(self.rows.items(), key=lambda kv: kv[1]["id"])
+                if env_id is None or e == env_id]
+
+
+def cbor_decode(data):
+    """Decodes the subset PayloadCodec emits: ints, byte and text strings, arrays, null."""
+
+    def item(pos):
+        b = data[pos]
+        major, info = b >> 5, b & 0x1F
+        pos += 1
+        if b == 0xF6:
+            return None, pos
+        if info < 24:
+            value = info
+        elif info in (24, 25, 26, 27):
+            size = 1 << (info - 24)
+            value = int.from_bytes(data[pos:pos + size], "big")
+            pos += size
+        else:
+            raise ValueError("unsupported CBOR head")
+        if major == 0:
+            return value, pos
+        if major == 1:
+            return -1 - value, pos
+        if major in (2, 3):
+            raw = data[pos:pos + value]
+            if len(raw) != value:
+                raise ValueError("truncated CBOR string")
+            return (bytes(raw) if major == 2 else raw.decode()), pos + value
+        if major == 4:
+            out = []
+            for _ in range(value):
+                v, pos = item(pos)
+                out.append(v)
+            return out, pos
+        raise ValueError("unsupported CBOR major type")
+
+    value, pos = item(0)
+    if pos != len(data):
+        raise ValueError("trailing bytes")
+    return value
+
+
+def scaled(value, scale):
+    return None if value is None else value / scale
+
+
+def cbor_row(fields):
+    env_id, seq, epoch, temp, dissolved, turbidity, ph = fields
+    if isinstance(env_id, bytes):
+        env_id = str(uuid.UUID(bytes=env_id))
+    return {
+        "env_id": env_id,
+        "seq": seq,
+        "temp": scaled(temp, 100),
+        "dissolved_oxygen": scaled(dissolved, 100),
+        "turbidity": scaled(turbidity, 1000),  # percent * 10 on the wire, a fraction in the table
+        "ph": scaled(ph, 100),
+        "created_at": datetime.fromtimestamp(epoch, timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ"),
+    }
+
+
+def decode_rows(body, content_type, content_encoding):
+    if content_encoding == "deflate":
+        body = zlib.decompress(body)
+    if content_type.startswith("application/cbor"):
+        value = cbor_decode(body)
+        rows = value if value and isinstance(value[0], list) else [value]
+        return [cbor_row(r) for r in rows]
+    value = json.loads(body)
+    return value if isinstance(value, list) else [value]
+
+
+class StandIn:
+    def __init__(self, args):
+        self.args = args
+        self.random = random.Random(args.seed)
+        self.stats = Stats()
+        self.store = Store(self.stats)
+        self.channels = {}  # topic -> set of Socket
+        self.presence = {}  # topic -> {key: meta}
+
+    def log(self, *parts):
+        if self.args.verbose:
+            print(time.strftime("%H:%M:%S"), *parts, flush=True)
+
+    def chance(self, rate):
+        return rate > 0 and self.random.random() < rate
+
+    async def delay(self):
+        ms = self.args.latency_ms + self.random.uniform(-self.args.jitter_ms, self.args.jitter_ms)
+        if ms > 0:
+            await asyncio.sleep(ms / 1000)
+
+    def authorized(self, headers, query):
+        key = self.args.api_key
+        return not key or headers.get("apikey") == key or query.get("apikey", [None])[0] == key
+
+    # HTTP
+
+    async def handle(self, reader, writer):
+        try:
+            while True:
+                line = await reader.readline()
+                if not line:
+                    break
+                method, target, _ = line.decode("latin-1").split(" ", 2)
+                headers = {}
+                while True:
+                    h = (await reader.readline()).decode("latin-1").strip()
+                    if not h:
+                        break
+                    name, _, value = h.partition(":")
+                    headers[name.strip().lower()] = value.strip()
+
+                if headers.get("upgrade", "").lower() == "websocket":
+                    await Socket(self, reader, writer).run(headers, target)
+                    return
+
+                body = await reader.readexactly(int(headers.get("content-length", 0)))
+                self.stats.requests += 1
+                # /stats is how harnesses check the outcome, it never fails
+                faulty = urlsplit(target).path != "/stats"
+                if faulty:
+                    await self.delay()
+                if faulty and self.chance(self.args.drop_rate):
+                    self.stats.injected_drops += 1
+                    break
+
+                status, payload = self.route(method, target, headers, body)
+                data = b"" if payload is None else json.dumps(payload).encode()
+                reason = {200: "OK", 201: "Created", 204: "No Content"}.get(status, "Error")
+                writer.write(f"HTTP/1.1 {status} {reason}\r\nContent-Type: application/json\r\n"
+                             f"Content-Length: {len(data)}\r\n\r\n".encode() + data)
+                await writer.drain()
+                if headers.get("connection", "").lower() == "close":
+                    break
+        except (ConnectionError, asyncio.IncompleteReadError, ValueError):
+            pass
+        finally:
+            writer.close()
+
+    def route(self, method, target, headers, body):
+        url = urlsplit(target)
+        query = parse_qs(url.query)
+
+        if url.path == "/stats":
+            return 200, self.stats.as_dict(self.store, self.presence)
+        if not self.authorized(headers, query):
+            return 401, {"message": "Invalid API key"}
+
+        if url.path == "/auth/v1/token" and method == "POST":
+            return 200, {"access_token": "standin." + uuid.uuid4().hex, "token_type": "bearer",
+                         "expires_in": self.args.token_ttl, "refresh_token": uuid.uuid4().hex[:22]}
+
+        if url.path == "/rest/v1/measurements":
+            if method == "GET":
+                env = query.get("env_id", [None])[0]
+                return 200, self.store.select(env[3:] if env and env.startswith("eq.") else None)
+            if method == "POST":
+                if self.chance(self.args.error_rate):
+                    self.stats.injected_errors += 1
+                    return 503, {"message": "injected failure"}
+                try:
+                    rows = decode_rows(body, headers.get("content-type", ""), headers.get("content-encoding", ""))
+                except (ValueError, zlib.error, TypeError, KeyError, IndexError) as error:
+                    return 400, {"message": f"bad payload: {error}"}
+                self.stats.rest_batches += 1
+                self.stats.upload()
+                self.store.upsert(rows)
+                self.log("rest", len(rows), "rows")
+                return 201, None
+
+        if url.path == "/rest/v1/aquarium" and method == "PATCH":
+            target_id = query.get("id", ["eq."])[0][3:]
+            record = dict(self.store.aquariums.get(target_id, {"id": target_id}), **json.loads(body or b"{}"))
+            old = self.store.aquariums.get(target_id)
+            self.store.aquariums[target_id] = record
+            self.notify_update(record, old)
+            return 204, None
+
+        return 404, {"message": "not found"}
+
+    # Realtime
+
+    def notify_update(self, record, old):
+        topic_filter = f"id=eq.{record['id']}"
+        data = {"type": "UPDATE", "schema": "public", "table": "aquarium",
+                "commit_timestamp": datetime.now(timezone.utc).isoformat(),
+                "record": record, "old_record": old or {"id": record["id"]}, "errors": None}
+        for sockets in self.channels.values():
+            for socket in sockets:
+                for topic, joined in socket.joined.items():
+                    if joined.get("filter") == topic_filter:
+                        socket.push(topic, "postgres_changes", {"data": data, "ids": [1]})
+
+
+class Socket:
+    """One websocket, speaking Phoenix vsn 1.0.0 JSON messages."""
+
+    def __init__(self, server, reader, writer):
+        self.server = server
+        self.reader = reader
+        self.writer = writer
+        self.joined = {}  # topic -> {"filter", "ack", "join_ref", "presence_key"}
+
+    async def run(self, headers, target):
+        server = self.server
+        query = parse_qs(urlsplit(target).query)
+        if not server.authorized(headers, query):
+            self.writer.write(b"HTTP/1.1 401 Unauthorized\r\nContent-Length: 0\r\n\r\n")
+            await self.writer.drain()
+            self.writer.close()
+            return
+
+        accept = base64.b64encode(hashlib.sha1((headers["sec-websocket-key"] + WS_GUID).encode()).digest())
+        self.writer.write(b"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          b"Sec-WebSocket-Accept: " + accept + b"\r\n\r\n")
+        server.stats.sockets_opened += 1
+        server.stats.sockets_open += 1
+        try:
+            while True:
+                opcode, payload = await self.read_frame()
+                if opcode == 0x8:
+                    self.send_frame(0x8, payload[:2])
+                    break
+                if opcode == 0x9:
+                    self.send_frame(0xA, payload)
+                elif opcode == 0x1:
+                    await server.delay()
+                    self.message(json.loads(payload))
+                    await self.writer.drain()
+                    if server.chance(server.args.disconnect_rate):
+                        server.stats.injected_disconnects += 1
+                        server.log("injected disconnect")
+                        break
+        except (ConnectionError, asyncio.IncompleteReadError, ValueError):
+            pass
+        finally:
+            server.stats.sockets_open -= 1
+            self.leave_all()
+            self.writer.close()
+
+    async def read_frame(self):
+        data, first = b"", 0x1
+        while True:
+            b0, b1 = await self.reader.readexactly(2)
+            size = b1 & 0x7F
+            if size == 126:
+                size = struct.unpack(">H", await self.reader.readexactly(2))[0]
+            elif size == 127:
+                size = struct.unpack(">Q", await self.reader.readexactly(8))[0]
+            mask = await self.reader.readexactly(4) if b1 & 0x80 else b"\0\0\0\0"
+            chunk = bytearray(await self.reader.readexactly(size))
+            for i in range(size):
+                chunk[i] ^= mask[i & 3]
+            opcode = b0 & 0x0F
+            if opcode >= 0x8:
+                return opcode, bytes(chunk)
+            data += chunk
+            if opcode:
+                first = opcode
+            if b0 & 0x80:
+                return first, data
+
+    def send_frame(self, opcode, payload):
+        size = len(payload)
+        if size < 126:
+            head = struct.pack(">BB", 0x80 | opcode, size)
+        elif size < 0x10000:
+            head = struct.pack(">BBH", 0x80 | opcode, 126, size)
+        else:
+            head = struct.pack(">BBQ", 0x80 | opcode, 127, size)
+        self.writer.write(head + payload)
+
+    def push(self, topic, event, payload, ref=None, join_ref=None):
+        message = {"topic": topic, "event": event, "payload": payload, "ref": ref}
+        if join_ref is not None:
+            message["join_ref"] = join_ref
+        self.send_frame(0x1, json.dumps(message, separators=(",", ":")).encode())
+
+    def reply(self, message, status="ok", response=None):
+        self.push(message["topic"], "phx_reply", {"status": status, "response": response or {}},
+                  message.get("ref"), message.get("join_ref"))
+
+    def others(self, topic):
+        return [s for s in self.server.channels.get(topic, ()) if s is not self]
+
+    def message(self, message):
+        server = self.server
+        topic, event, payload = message.get("topic"), message.get("event"), message.get("payload") or {}
+
+        if topic == "phoenix" and event == "heartbeat":
+            server.stats.heartbeats += 1
+            self.reply(message)
+            return
+
+        if event == "phx_join":
+            config = payload.get("config", {})
+            changes = config.get("postgres_changes", [])
+            self.joined[topic] = {
+                "filter": changes[0].get("filter") if changes else None,
+                "ack": config.get("broadcast", {}).get("ack", False),
+                "join_ref": message.get("join_ref"),
+                "presence_key": config.get("presence", {}).get("key") or uuid.uuid4().hex,
+            }
+            server.channels.setdefault(topic, set()).add(self)
+            server.stats.joins += 1
+            response = {"postgres_changes": [dict(c, id=i + 1) for i, c in enumerate(changes)]}
+            self.reply(message, response=response)
+            state = server.presence.get(topic, {})
+            self.push(topic, "presence_state", {k: {"metas": [m]} for k, m in state.items()})
+            return
+
+        if topic not in self.joined:
+            self.reply(message, "error", {"reason": "unmatched topic"})
+            return
+
+        if event == "phx_leave":
+            self.leave(topic)
+            self.reply(message)
+        elif event == "access_token":
+            self.reply(message)
+        elif event == "presence":
+            key = self.joined[topic]["presence_key"]
+            meta = dict(payload.get("payload", {}), phx_ref=uuid.uuid4().hex[:8])
+            server.presence.setdefault(topic, {})[key] = meta
+            for socket in self.server.channels.get(topic, ()):
+                socket.push(topic, "presence_diff", {"joins": {key: {"metas": [meta]}}, "leaves": {}})
+            self.reply(message)
+        elif event == "broadcast":
+            self.broadcast(topic, message, payload)
+        else:
+            self.reply(message, "error", {"reason": f"unknown event {event}"})
+
+    def broadcast(self, topic, message, payload):
+        server = self.server
+        ack = self.joined[topic]["ack"]
+
+        if payload.get("event") == BROADCAST_EVENT:
+            if server.chance(server.args.drop_rate):
+                server.stats.injected_drops += 1
+                return
+            if server.chance(server.args.error_rate):
+                server.stats.injected_errors += 1
+                if ack:
+                    self.reply(message, "error", {"reason": "injected failure"})
+                return
+            server.stats.broadcasts += 1
+            server.log("broadcast", topic)
+            if server.args.ingest_broadcasts:
+                server.stats.upload()
+                server.store.upsert(payload.get("payload", {}).get("rows", []))
+
+        for socket in self.others(topic):
+            socket.push(topic, "broadcast", payload)
+        if ack:
+            self.reply(message)
+
+    def leave(self, topic):
+        self.joined.pop(topic, None)
+        sockets = self.server.channels.get(topic)
+        if sockets:
+            sockets.discard(self)
+            if not sockets:
+                del self.server.channels[topic]
+
+    def leave_all(self):
+        for topic, joined in list(self.joined.items()):
+            meta = self.server.presence.get(topic, {}).pop(joined["presence_key"], None)
+            self.leave(topic)
+            if meta:
+                for socket in self.server.channels.get(topic, ()):
+                    socket.push(topic, "presence_diff", {"joins": {}, "leaves": {joined["presence_key"]: {"metas": [meta]}}})
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=54321)
+    parser.add_argument("--api-key", default="", help="required apikey, anything goes when empty")
+    parser.add_argument("--token-ttl", type=int, default=3600, help="expires_in of issued tokens, seconds")
+    parser.add_argument("--latency-ms", type=float, default=0)
+    parser.add_argument("--jitter-ms", type=float, default=0)
+    parser.add_argument("--error-rate", type=float, default=0)
+    parser.add_argument("--drop-rate", type=float, default=0)
+    parser.add_argument("--disconnect-rate", type=float, default=0)
+    parser.add_argument("--seed", type=int, default=None)
+    parser.add_argument("--ingest-broadcasts", action="store_true",
+                        help="store measurement broadcasts, as an ingest subscriber on the channel would")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    async def serve():
+        standin = StandIn(args)
+        server = await asyncio.start_server(standin.handle, args.host, args.port, backlog=4096)
+        print(f"stand-in listening on {args.host}:{args.port}", flush=True)
+        async with server:
+            await server.serve_forever()
+
+    try:
+        asyncio.run(serve())
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()